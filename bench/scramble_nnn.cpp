@@ -0,0 +1,130 @@
+// Copyright 2019 Yunqi Ouyang
+// Benchmark of ScramblerNNN and of FaceletCubeNNN moves on big cubes.
+//
+// Usage: bench_scramble_nnn [--scrambles=N] [--runs=N] [--seed=N] [SIZE...]
+//
+// For each size (4, 5, 7, 11, 17 and 33 by default) each run generates the
+// same scrambles with a seeded scrambler, then applies their moves to a
+// cube again, which is the part of the scrambler turning the cube. The
+// summary gives the median and range over the runs.
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "cube_util/puzzle/facelet_cube_nnn.hpp"
+#include "cube_util/scramble/scrambler_nnn.hpp"
+
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+using cube_util::FaceletCubeNNN;
+using cube_util::MoveSequence;
+using cube_util::ScramblerNNN;
+
+namespace {
+
+/**
+ * Get the value of an option like `--name=value`.
+ * @param arg the argument
+ * @param name name of the option with the leading dashes and the `=`
+ * @param[out] value the value if the argument is the option
+ * @returns whether the argument is the option
+ */
+bool parseOption(const char *arg, const char *name, uint64_t *value) {
+  auto n = strlen(name);
+  if (strncmp(arg, name, n) != 0) {
+    return false;
+  }
+  *value = strtoull(arg + n, nullptr, 10);
+  return true;
+}
+
+/**
+ * Get the median of some values.
+ * @param values the values
+ * @returns the median
+ */
+double median(vector<double> values) {
+  std::sort(values.begin(), values.end());
+  auto n = values.size();
+  return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+/**
+ * Get the seconds since a time point.
+ * @param start the time point
+ * @returns the seconds
+ */
+double secondsSince(steady_clock::time_point start) {
+  duration<double> seconds = steady_clock::now() - start;
+  return seconds.count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t nScrambles = 100;
+  uint64_t nRuns = 7;
+  uint64_t seed = 2019;
+  vector<uint16_t> sizes;
+  for (auto i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') {
+      sizes.push_back(strtoul(argv[i], nullptr, 10));
+    } else if (!parseOption(argv[i], "--scrambles=", &nScrambles) &&
+               !parseOption(argv[i], "--runs=", &nRuns) &&
+               !parseOption(argv[i], "--seed=", &seed)) {
+      fprintf(stderr, "unknown option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (nScrambles == 0 || nRuns == 0) {
+    fprintf(stderr, "--scrambles and --runs need to be positive\n");
+    return 1;
+  }
+  if (sizes.empty()) {
+    sizes = {4, 5, 7, 11, 17, 33};
+  }
+
+  printf("%" PRIu64 " scrambles, %" PRIu64 " runs, seed %" PRIu64 "\n",
+         nScrambles, nRuns, seed);
+  printf("%4s %16s %16s %12s\n", "size", "us/scramble", "us/move",
+         "min us/move");
+  for (auto size : sizes) {
+    auto scrambler = ScramblerNNN(size);
+    vector<double> scrambleTimes;
+    vector<double> moveTimes;
+    uint64_t nMoves = 0;
+    for (uint64_t r = 0; r < nRuns; r++) {
+      scrambler.seed(seed);
+      vector<unique_ptr<MoveSequence>> scrambles;
+      auto start = steady_clock::now();
+      for (uint64_t i = 0; i < nScrambles; i++) {
+        scrambles.push_back(scrambler.scramble());
+      }
+      scrambleTimes.push_back(secondsSince(start) / nScrambles * 1e6);
+
+      nMoves = 0;
+      auto fc = FaceletCubeNNN(size);
+      start = steady_clock::now();
+      for (const auto &s : scrambles) {
+        fc.reset();
+        for (auto move : s->getMoves()) {
+          fc.move(move);
+        }
+        nMoves += s->getLength();
+      }
+      moveTimes.push_back(secondsSince(start) / nMoves * 1e6);
+    }
+    printf("%4u %16.2f %16.4f %12.4f\n", size, median(scrambleTimes),
+           median(moveTimes),
+           *std::min_element(moveTimes.begin(), moveTimes.end()));
+  }
+  return 0;
+}
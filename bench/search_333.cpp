@@ -0,0 +1,147 @@
+// Copyright 2019 Yunqi Ouyang
+// Benchmark of Cube333Solver on a fixed set of random cubes.
+//
+// Usage: bench_search_333 [--cubes=N] [--runs=N] [--length=N] [--seed=N]
+//                         [--huge-pages] [--symmetry-pruning]
+//
+// Tables are loaded before the first run, from CUBE_UTIL_TABLE_DIR when it's
+// set. Each run solves the same cubes, and the summary gives the median and
+// range over the runs. Nodes per second are only reported by builds with
+// search statistics, see CUBE_UTIL_SEARCH_STATS.
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cube_util/cube_333_solver.hpp"
+#include "cube_util/puzzle/cubie_cube_333.hpp"
+#include "cube_util/random.hpp"
+#include "cube_util/search_stats.hpp"
+#include "cube_util/table_store.hpp"
+#include "cube_util/warmup.hpp"
+
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+using cube_util::Cube333Solver;
+using cube_util::CubieCube333;
+using cube_util::Xoshiro256;
+using cube_util::kSearchStatsEnabled;
+using cube_util::warmup;
+using cube_util::tables::getHugePages;
+using cube_util::tables::setHugePages;
+
+namespace {
+
+/** Results of one run */
+struct Run {
+  /** Wall time of the run in seconds */
+  double seconds;
+  /** Nodes expanded, 0 without search statistics */
+  uint64_t nodes;
+};
+
+/**
+ * Get the value of an option like `--name=value`.
+ * @param arg the argument
+ * @param name name of the option with the leading dashes and the `=`
+ * @param[out] value the value if the argument is the option
+ * @returns whether the argument is the option
+ */
+bool parseOption(const char *arg, const char *name, uint64_t *value) {
+  auto n = strlen(name);
+  if (strncmp(arg, name, n) != 0) {
+    return false;
+  }
+  *value = strtoull(arg + n, nullptr, 10);
+  return true;
+}
+
+/**
+ * Print the median, the smallest and the largest of some values.
+ * @param label what the values are
+ * @param values the values
+ */
+void printSummary(const char *label, vector<double> values) {
+  std::sort(values.begin(), values.end());
+  auto n = values.size();
+  auto median = n % 2 == 1 ? values[n / 2] :
+      (values[n / 2 - 1] + values[n / 2]) / 2;
+  printf("%-16s median %10.3f  min %10.3f  max %10.3f\n", label, median,
+         values.front(), values.back());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t nCubes = 20;
+  uint64_t nRuns = 7;
+  uint64_t maxLength = 21;
+  uint64_t seed = 2019;
+  auto symmetryPruning = false;
+  for (auto i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--huge-pages") == 0) {
+      setHugePages(true);
+    } else if (strcmp(argv[i], "--symmetry-pruning") == 0) {
+      symmetryPruning = true;
+    } else if (!parseOption(argv[i], "--cubes=", &nCubes) &&
+               !parseOption(argv[i], "--runs=", &nRuns) &&
+               !parseOption(argv[i], "--length=", &maxLength) &&
+               !parseOption(argv[i], "--seed=", &seed)) {
+      fprintf(stderr, "unknown option: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (nCubes == 0 || nRuns == 0) {
+    fprintf(stderr, "--cubes and --runs need to be positive\n");
+    return 1;
+  }
+
+  warmup(0, symmetryPruning);
+  auto random = Xoshiro256(seed);
+  vector<CubieCube333> cubes;
+  for (uint64_t i = 0; i < nCubes; i++) {
+    cubes.push_back(CubieCube333::randomCube(&random));
+  }
+
+  printf("%" PRIu64 " cubes, max length %" PRIu64 ", seed %" PRIu64 "%s%s\n",
+         nCubes, maxLength, seed, symmetryPruning ? ", symmetry pruning" : "",
+         getHugePages() ? ", huge pages" : "");
+  vector<Run> runs;
+  for (uint64_t r = 0; r < nRuns; r++) {
+    Run run = {0, 0};
+    auto start = steady_clock::now();
+    for (const auto &cc : cubes) {
+      auto solver = Cube333Solver(cc);
+      solver.setSymmetryPruning(symmetryPruning);
+      solver.solve(maxLength);
+      run.nodes += solver.getSearchStats().nodes();
+    }
+    duration<double> seconds = steady_clock::now() - start;
+    run.seconds = seconds.count();
+    runs.push_back(run);
+    printf("run %2" PRIu64 ": %8.3f s", r + 1, run.seconds);
+    if (kSearchStatsEnabled) {
+      printf("  %8.3f Mnodes/s", run.nodes / run.seconds / 1e6);
+    }
+    printf("\n");
+  }
+
+  vector<double> solves;
+  vector<double> mnodes;
+  for (const auto &run : runs) {
+    solves.push_back(nCubes / run.seconds);
+    mnodes.push_back(run.nodes / run.seconds / 1e6);
+  }
+  printSummary("solves/s", solves);
+  if (kSearchStatsEnabled) {
+    printSummary("Mnodes/s", mnodes);
+  }
+  return 0;
+}
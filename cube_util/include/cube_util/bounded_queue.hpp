@@ -0,0 +1,146 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_BOUNDED_QUEUE_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_BOUNDED_QUEUE_HPP_
+#include <cstddef>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace cube_util {
+
+using std::atomic;
+using std::unique_ptr;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A fixed-capacity lock-free queue for multiple producers and consumers,
+/// after the bounded MPMC queue by Dmitry Vyukov.
+/// Each cell carries a sequence number telling whether it's ready to be
+/// written or read at a given position, so push() and pop() only contend
+/// on one atomic counter each.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class BoundedQueue {
+  /** A slot of the queue */
+  struct Cell {
+    /** Position the cell is ready for, plus 1 once written */
+    atomic<size_t> sequence;
+    /** The element */
+    T data;
+  };
+
+  /** Number of cells */
+  size_t capacity_;
+
+  /** The cells */
+  unique_ptr<Cell[]> cells_;
+
+  /** Keeps the producer and consumer counters on separate cache lines */
+  char pad0_[64];
+
+  /** Position of the next push */
+  atomic<size_t> push_pos_;
+
+  char pad1_[64];
+
+  /** Position of the next pop */
+  atomic<size_t> pop_pos_;
+
+  char pad2_[64];
+
+ public:
+  /**
+   * Constructor of the class.
+   * @param capacity max number of elements, at least 1
+   */
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity), cells_(new Cell[capacity]), push_pos_(0),
+        pop_pos_(0) {
+    if (capacity == 0) {
+      throw std::invalid_argument("capacity needs to be positive");
+    }
+    for (size_t i = 0; i < capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue &) = delete;
+
+  BoundedQueue& operator=(const BoundedQueue &) = delete;
+
+  /**
+   * Add an element to the queue unless it's full.
+   * @param[inout] value the element, moved from if it's added
+   * @returns whether the element is added
+   */
+  bool push(T *value) {
+    auto pos = push_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto &cell = cells_[pos % capacity_];
+      auto seq = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          cell.data = std::move(*value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Remove the oldest element from the queue unless it's empty.
+   * @param[out] value the element removed
+   * @returns whether an element is removed
+   */
+  bool pop(T *value) {
+    auto pos = pop_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto &cell = cells_[pos % capacity_];
+      auto seq = cell.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<ptrdiff_t>(seq - (pos + 1));
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          *value = std::move(cell.data);
+          cell.sequence.store(pos + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Get the number of elements in the queue. It may be out of date by the
+   * time it returns if other threads are using the queue.
+   * @returns number of elements
+   */
+  size_t size() const {
+    auto pop = pop_pos_.load(std::memory_order_relaxed);
+    auto push = push_pos_.load(std::memory_order_relaxed);
+    return push > pop ? push - pop : 0;
+  }
+
+  /**
+   * Get the max number of elements.
+   * @returns the capacity
+   */
+  size_t capacity() const {
+    return capacity_;
+  }
+};
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_BOUNDED_QUEUE_HPP_
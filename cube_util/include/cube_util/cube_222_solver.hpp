@@ -2,13 +2,18 @@
 #ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_CUBE_222_SOLVER_HPP_
 #define CUBE_UTIL_INCLUDE_CUBE_UTIL_CUBE_222_SOLVER_HPP_
 #include <memory>
+#include <vector>
 
 #include "cube_util/puzzle/cubie_cube_222.hpp"
 #include "cube_util/move_sequence.hpp"
+#include "cube_util/search_stats.hpp"
+#include "cube_util/thread_pool.hpp"
 
 namespace cube_util {
 
+using std::shared_ptr;
 using std::unique_ptr;
+using std::vector;
 
 using cube222::kMaxLength;
 
@@ -25,8 +30,17 @@ class Cube222Solver {
   /** Length of the solution */
   int16_t solution_length_ = -1;
 
-  bool search(uint16_t perm, uint16_t twist, uint16_t moveCount,
-              uint16_t lastAxis, uint16_t depth, bool saveSolution);
+  /** Statistics of the last search */
+  SearchStats stats_;
+
+  /** Whether to use the complete distance table */
+  bool distance_table_ = false;
+
+  bool search(uint16_t perm, uint16_t twist, uint16_t distance,
+              uint16_t moveCount, uint16_t state, uint16_t depth,
+              bool saveSolution);
+
+  static uint32_t stepCloser(uint32_t index, uint16_t *move);
 
   void _solve(uint16_t minLength);
 
@@ -45,6 +59,25 @@ class Cube222Solver {
    */
   int16_t getSolutionLength() const;
 
+  /**
+   * Get statistics of the last search run by solve(), generate() or
+   * isSolvableIn(). They are only collected when #kSearchStatsEnabled is
+   * true.
+   * @returns the statistics
+   */
+  const SearchStats& getSearchStats() const;
+
+  /**
+   * Use the complete distance table, which stores the optimal solution
+   * length modulo 3 of every state in about 900KB and is generated on first
+   * use. Optimal solutions are then found by walking towards the solved
+   * state without searching, isSolvableIn() takes a few table lookups, and
+   * longer solutions are searched with exact distances for pruning.
+   * Solutions are the same as without the table.
+   * @param enabled whether to use the table
+   */
+  void setDistanceTable(bool enabled);
+
   /**
    * Get solution sequence of at least `minLength` moves for the cube.
    * @param minLength minimal length of the solution
@@ -52,6 +85,21 @@ class Cube222Solver {
    */
   unique_ptr<MoveSequence> solve(uint16_t minLength = 0);
 
+  /**
+   * Solve many cubes at once, spreading the cubes over a thread pool.
+   * Each worker reuses one solver for all the cubes it takes, and each cube
+   * gets the same solution solve() gives.
+   * @param cubes the cubes to solve
+   * @param minLength minimal length of the solutions
+   * @param[out] solutions array of `cubes.size()` elements to store the
+   * solution of each cube in
+   * @param pool the thread pool to solve on, or nullptr to use a new pool of
+   * all hardware threads
+   */
+  static void solveBatch(const vector<CubieCube222> &cubes, uint16_t minLength,
+                         unique_ptr<MoveSequence> *solutions,
+                         shared_ptr<ThreadPool> pool = nullptr);
+
   /**
    * Get generator sequence of at least `minLength` moves for the cube.
    * @param minLength minimal length of the generator
@@ -79,6 +127,21 @@ class Cube222Solver {
    * @returns the pruning value
    */
   static uint16_t getTwistPruning(uint16_t twist);
+
+  /**
+   * Get optimal solution length modulo 3 of a state.
+   * @param index the state index, `perm` * `kNTwist` + `twist`
+   * @returns the optimal solution length modulo 3
+   */
+  static uint16_t getDistanceMod3(uint32_t index);
+
+  /**
+   * Get optimal solution length of a state with the complete distance
+   * table.
+   * @param index the state index, `perm` * `kNTwist` + `twist`
+   * @returns the optimal solution length
+   */
+  static uint16_t getDistance(uint32_t index);
 };
 
 }  // namespace cube_util
@@ -1,14 +1,26 @@
 // Copyright 2019 Yunqi Ouyang
 #ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_CUBE_333_SOLVER_HPP_
 #define CUBE_UTIL_INCLUDE_CUBE_UTIL_CUBE_333_SOLVER_HPP_
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "cube_util/puzzle/cubie_cube_333.hpp"
 #include "cube_util/move_sequence.hpp"
+#include "cube_util/search_stats.hpp"
+#include "cube_util/thread_pool.hpp"
 
 namespace cube_util {
 
+using std::atomic;
+using std::function;
+using std::shared_ptr;
 using std::unique_ptr;
+using std::vector;
+
+using std::chrono::steady_clock;
 
 using cube333::kMaxLength;
 
@@ -29,16 +41,133 @@ class Cube333Solver {
   /** Length of phase 1 of the solution */
   int16_t phase1_length_ = -1;
 
+  /**
+   * Bitmask of the indices into cube333::kPhase2Move allowed as the first
+   * phase 2 move after the phase 1 moves
+   */
+  uint32_t phase2_first_moves_ = 0;
+
+  /** How many moves in total is acceptable for the solution being searched */
+  uint16_t max_length_ = kMaxLength;
+
+  /** Whether to go on searching for shorter solutions after one is found */
+  bool improving_ = false;
+
+  /** Improving search stops once a solution of at most this length is found */
+  uint16_t target_length_ = 0;
+
+  /** Time for improving search to give up */
+  steady_clock::time_point deadline_;
+
+  /** Whether improving search has passed its deadline */
+  bool expired_ = false;
+
+  /** Phase 1 nodes visited since the deadline was last checked */
+  uint32_t unchecked_nodes_ = 0;
+
+  /** Shortest solution found by improving search */
+  array<uint16_t, kMaxLength> best_solution_;
+
+  /** Length of the shortest solution found by improving search */
+  int16_t best_length_ = -1;
+
+  /** Function called with each shorter solution found by improving search */
+  function<void(const MoveSequence &)> on_improve_;
+
+  /** Thread pool to search phase 1 on, or nullptr to search serially */
+  shared_ptr<ThreadPool> pool_;
+
+  /** Whether parallel searching returns the same solution as serial search */
+  bool deterministic_ = false;
+
+  /** Whether to use the flip-slice-twist pruning table in phase 1 */
+  bool sym_pruning_ = false;
+
+  /** Whether to search the inverse and the other two axes as well */
+  bool six_way_ = false;
+
+  /** Parallel tasks with index no less than this value stop searching */
+  const atomic<uint32_t> *cutoff_ = nullptr;
+
+  /** Index of the parallel task being searched by this solver */
+  uint32_t task_ = 0;
+
+  /** Statistics of the last search */
+  SearchStats stats_;
+
+  /** Coordinates phase 2 starts from, see updatePhase2Path() */
+  struct Phase2Coords {
+    /** Corner permutation index */
+    uint16_t cp;
+    /** U edges positions and permutation index */
+    uint16_t uEdge4;
+    /** D edges positions and permutation index */
+    uint16_t dEdge4;
+    /** E-slice edges positions and permutation index */
+    uint16_t sliceEdge4;
+  };
+
+  /** Coordinates after each prefix of the phase 1 moves in #solution_ */
+  array<Phase2Coords, cube333::kMaxPhase1Length + 1> phase2_path_;
+
+  /** Moves the entries of #phase2_path_ after the first are computed with */
+  array<uint16_t, cube333::kMaxPhase1Length> phase2_path_moves_;
+
+  /** Number of entries of #phase2_path_ after the first one computed */
+  uint16_t phase2_path_length_ = 0;
+
+  /** A phase 1 subtree to be searched by a parallel task */
+  struct Phase1Task {
+    /** Moves leading to the subtree */
+    array<uint16_t, 2> moves;
+    /** Corner orientation index of the subtree root */
+    uint16_t co;
+    /** Edge orientation index of the subtree root */
+    uint16_t eo;
+    /** E-slice edges positions index of the subtree root */
+    uint16_t slice;
+    /** Distance of the subtree root in the symmetry-reduced table */
+    uint16_t distance;
+    /** Phase 1 automaton state after the moves leading to the subtree */
+    uint16_t state;
+  };
+
   bool _solve(uint16_t maxLength);
 
-  bool phase1(uint16_t co, uint16_t eo, uint16_t slice, uint16_t moveCount,
-              uint16_t lastAxis, uint16_t depth, uint16_t maxLength,
+  bool searchPhase1(uint16_t moveCount);
+
+  bool sixWaySolve();
+
+  uint16_t phase1Pruning(uint16_t co, uint16_t eo, uint16_t slice) const;
+
+  uint32_t phase1Children(uint16_t co, uint16_t eo, uint16_t slice,
+                          uint16_t distance, uint16_t moveCount,
+                          uint16_t state, array<uint16_t, kNMove> *distances);
+
+  void collectPhase1Tasks(uint16_t co, uint16_t eo, uint16_t slice,
+                          uint16_t distance, uint16_t moveCount,
+                          uint16_t state, uint16_t depth,
+                          vector<Phase1Task> *tasks);
+
+  bool parallelPhase1(uint16_t co, uint16_t eo, uint16_t slice,
+                      uint16_t distance, uint16_t moveCount);
+
+  bool expired();
+
+  bool phase1(uint16_t co, uint16_t eo, uint16_t slice, uint16_t distance,
+              uint16_t moveCount, uint16_t state, uint16_t depth,
               bool checkOnly = false);
 
-  bool initPhase2(uint16_t lastAxis, uint16_t depth, uint16_t maxLength);
+  void resetPhase2Path();
+
+  const Phase2Coords& updatePhase2Path(uint16_t depth);
+
+  bool initPhase2(uint16_t depth);
+
+  bool improve();
 
   bool phase2(uint16_t cp, uint16_t ud8EP, uint16_t sliceEP, uint16_t moveCount,
-              uint16_t lastAxis, uint16_t depth);
+              uint16_t state, uint16_t depth);
 
  public:
   Cube333Solver() = default;
@@ -55,6 +184,43 @@ class Cube333Solver {
    */
   int16_t getSolutionLength() const;
 
+  /**
+   * Get statistics of the last search run by solve(), generate(),
+   * solveImproving() or isSolvableIn(). They are only collected when
+   * #kSearchStatsEnabled is true.
+   * @returns the statistics
+   */
+  const SearchStats& getSearchStats() const;
+
+  /**
+   * Search phase 1 on multiple threads.
+   * The phase 1 search tree is split by its first two moves and the subtrees
+   * are searched on the thread pool. Once a solution is found, threads
+   * searching other subtrees stop early.
+   * @param pool the thread pool to search on, or nullptr to search serially
+   * @param deterministic whether to always return the same solution as the
+   * serial search does, otherwise the first solution found is returned
+   */
+  void setThreadPool(shared_ptr<ThreadPool> pool, bool deterministic = false);
+
+  /**
+   * Use the symmetry-reduced flip-slice-twist pruning table in phase 1.
+   * It gives much tighter lower bounds than the default tables, but takes
+   * about 35MB of memory and is generated on first use.
+   * @param enabled whether to use the table
+   */
+  void setSymmetryPruning(bool enabled);
+
+  /**
+   * Search six cubes at once: the cube and its inverse, each seen along the
+   * UD, RL and FB axes. Each phase 1 length is tried on all six before going
+   * deeper, and the first solution found is mapped back to the original
+   * cube. This finds short solutions noticeably faster on average and much
+   * faster for the worst cases. It applies to solve() and generate().
+   * @param enabled whether to search six ways
+   */
+  void setSixWaySearch(bool enabled);
+
   /**
    * Get solution sequence of at most `maxLength` moves for the cube.
    * @param maxLength maximal length of the solution
@@ -62,6 +228,39 @@ class Cube333Solver {
    */
   unique_ptr<MoveSequence> solve(uint16_t maxLength = kMaxLength);
 
+  /**
+   * Solve many cubes at once, spreading the cubes over a thread pool.
+   * Each worker reuses one solver for all the cubes it takes, and each cube
+   * gets the same solution solve() gives.
+   * @param cubes the cubes to solve
+   * @param maxLength maximal length of the solutions
+   * @param[out] solutions array of `cubes.size()` elements to store the
+   * solution of each cube in, with nullptr for cubes not solvable within
+   * `maxLength` moves
+   * @param pool the thread pool to solve on, or nullptr to use a new pool of
+   * all hardware threads
+   */
+  static void solveBatch(const vector<CubieCube333> &cubes, uint16_t maxLength,
+                         unique_ptr<MoveSequence> *solutions,
+                         shared_ptr<ThreadPool> pool = nullptr);
+
+  /**
+   * Keep searching for shorter solutions until `deadline`.
+   * Phase 1 lengths are tried in increasing order as solve() does, but the
+   * search goes on after a solution is found, with the total length bounded
+   * by the shortest solution so far. The search always runs on the calling
+   * thread.
+   * @param targetLength stop as soon as a solution of at most this length is
+   * found
+   * @param deadline time to stop searching at
+   * @param onImprove function called with each solution shorter than all
+   * solutions found before, or an empty function
+   * @returns a pointer to the shortest sequence found to solve the cube
+   */
+  unique_ptr<MoveSequence> solveImproving(
+      uint16_t targetLength, steady_clock::time_point deadline,
+      const function<void(const MoveSequence &)> &onImprove = nullptr);
+
   /**
    * Get generator sequence of at most `maxLength` moves for the cube.
    * @param maxLength maximal length of the generator
@@ -70,7 +269,8 @@ class Cube333Solver {
   unique_ptr<MoveSequence> generate(uint16_t maxLength = kMaxLength);
 
   /**
-   * Check whether the cube is solvable within given length.
+   * Check whether the cube is solvable within given length. It takes a
+   * single hash table probe for lengths up to cube333::kNearSolvedDepth.
    * @param maxLength maxLength to attempt
    * @returns whether the cube is solvable within given length
    */
@@ -92,6 +292,51 @@ class Cube333Solver {
    */
   static uint16_t getFlipSlicePruning(uint16_t flip, uint16_t slice);
 
+  /**
+   * Compare the phase 1 pruning values of all 18 children of a node with the
+   * moves left, as the search does without symmetry pruning. The pruning
+   * value of a child is the larger of getTwistSlicePruning() and
+   * getFlipSlicePruning().
+   * @param co corner orientation index of the node
+   * @param eo edge orientation index of the node
+   * @param slice E-slice edges positions index of the node
+   * @param moveCount moves left at the node
+   * @param[out] below bitmask of moves whose child has a pruning value less
+   * than `moveCount`
+   * @param[out] above bitmask of moves whose child has a pruning value
+   * greater than `moveCount`
+   * @param simd whether to use the SIMD kernel the search uses when the CPU
+   * supports it, rather than the scalar one
+   */
+  static void comparePhase1Children(uint16_t co, uint16_t eo, uint16_t slice,
+                                    uint16_t moveCount, uint32_t *below,
+                                    uint32_t *above, bool simd = true);
+
+  /**
+   * Get pruning value for a specified flip, E-slice position and twist
+   * combination, which is its exact distance from the solved combination.
+   * It's found by walking towards solved in the distance table, see
+   * getFlipSliceTwistDistanceMod3(), so it takes many lookups.
+   * @param flip the flip index to lookup
+   * @param slice the E-slice position index to lookup
+   * @param twist the twist index to lookup
+   * @returns the pruning value
+   */
+  static uint16_t getFlipSliceTwistPruning(uint16_t flip, uint16_t slice,
+                                           uint16_t twist);
+
+  /**
+   * Get distance modulo 3 of a specified flip, E-slice position and twist
+   * combination from the solved combination. The table is reduced by the 16
+   * symmetries preserving the UD axis, and stores 2 bits per entry.
+   * @param flip the flip index to lookup
+   * @param slice the E-slice position index to lookup
+   * @param twist the twist index to lookup
+   * @returns the distance modulo 3
+   */
+  static uint16_t getFlipSliceTwistDistanceMod3(uint16_t flip, uint16_t slice,
+                                                uint16_t twist);
+
   /**
    * Get pruning value for a specified corner permutation and
    * E-slice position combination.
@@ -109,6 +354,14 @@ class Cube333Solver {
    * @returns the pruning value
    */
   static uint16_t getUD8EPSliceEPPruning(uint16_t ud8EP, uint16_t sliceEP);
+
+  /**
+   * Get the distance of a cube from the solved state if it's at most
+   * cube333::kNearSolvedDepth, looked up in a hash table of all such cubes.
+   * @param cc the cube
+   * @returns the distance, or cube333::kNearSolvedDepth + 1 if it's farther
+   */
+  static uint16_t getNearSolvedDistance(const CubieCube333 &cc);
 };
 }  // namespace cube_util
 
@@ -0,0 +1,150 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_MOVE_AUTOMATON_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_MOVE_AUTOMATON_HPP_
+#include <cstddef>
+#include <cstdint>
+
+#include <set>
+#include <vector>
+
+namespace cube_util {
+
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A finite-state automaton accepting move sequences without redundant parts.
+/// A sequence is redundant if a shorter one, or an earlier one of the same
+/// length in move index order, leads to the same cube state. Such sequences
+/// are never needed by a search trying moves in index order, since replacing
+/// the redundant part of any solution with the other sequence gives a
+/// solution at most as long. Searches carry a state instead of the last
+/// move, and only try the moves allowed in it.
+////////////////////////////////////////////////////////////////////////////////
+class MoveAutomaton {
+  /** Number of moves */
+  uint16_t n_moves_ = 0;
+
+  /** State reached by each move from each state, or #kDead */
+  vector<uint16_t> next_;
+
+  /** Bitmask of moves allowed in each state */
+  vector<uint32_t> moves_;
+
+ public:
+  /** State before any move */
+  static const uint16_t kStart = 0;
+
+  /** Transition of a move not allowed */
+  static const uint16_t kDead = 0xffff;
+
+  MoveAutomaton() = default;
+
+  /**
+   * Constructor of the class, building the automaton rejecting sequences
+   * containing any of the given sequences.
+   * @param nMoves number of moves, at most 32
+   * @param forbidden the sequences to reject, none of which contains
+   * another one, with fewer than #kDead prefixes in total
+   */
+  MoveAutomaton(uint16_t nMoves, const vector<vector<uint16_t>> &forbidden);
+
+  /**
+   * Get the state reached by a move.
+   * @param state the current state
+   * @param move the move index
+   * @returns the new state, or #kDead if the move is not allowed
+   */
+  uint16_t next(uint16_t state, uint16_t move) const {
+    return next_[state * n_moves_ + move];
+  }
+
+  /**
+   * Get the moves allowed in a state.
+   * @param state the state
+   * @returns bitmask of the allowed move indices
+   */
+  uint32_t getMoves(uint16_t state) const {
+    return moves_[state];
+  }
+
+  /**
+   * Get the number of states.
+   * @returns the number of states
+   */
+  uint16_t size() const {
+    return moves_.size();
+  }
+
+  /**
+   * Get the memory used by the transitions and allowed moves.
+   * @returns the memory in bytes
+   */
+  size_t bytes() const {
+    return next_.size() * sizeof(next_[0]) + moves_.size() * sizeof(moves_[0]);
+  }
+};
+
+/**
+ * Find the shortest redundant move sequences up to a length, see
+ * MoveAutomaton. Sequences are enumerated in order of length and then of
+ * move index, skipping those containing a redundant sequence already found,
+ * and a sequence is redundant if it leads to a state some sequence before it
+ * leads to.
+ * @param nMoves number of moves
+ * @param maxLength max length of the sequences
+ * @param solved the solved cube
+ * @param doMove function taking a cube and a move index, returning the cube
+ * the move leads to
+ * @param key function taking a cube, returning a value identifying its
+ * state, which needs to be ordered
+ * @returns the redundant sequences, none of which contains another one
+ */
+template<typename CUBE, typename MOVE, typename KEY>
+vector<vector<uint16_t>> findRedundantSequences(uint16_t nMoves,
+                                                uint16_t maxLength,
+                                                const CUBE &solved,
+                                                const MOVE &doMove,
+                                                const KEY &key) {
+  vector<vector<uint16_t>> ret;
+  std::set<vector<uint16_t>> redundant;
+  std::set<decltype(key(solved))> seen = {key(solved)};
+  vector<vector<uint16_t>> sequences = {{}};
+  vector<CUBE> cubes = {solved};
+  for (auto length = 1; length <= maxLength; length++) {
+    vector<vector<uint16_t>> nextSequences;
+    vector<CUBE> nextCubes;
+    for (size_t i = 0; i < sequences.size(); i++) {
+      for (uint16_t move = 0; move < nMoves; move++) {
+        auto s = sequences[i];
+        s.push_back(move);
+        // the sequence without its last move contains no redundant part, so
+        // only parts ending with the move need to be checked
+        auto containsRedundant = false;
+        for (auto begin = s.begin(); begin != s.end(); ++begin) {
+          if (redundant.count(vector<uint16_t>(begin, s.end())) != 0) {
+            containsRedundant = true;
+            break;
+          }
+        }
+        if (containsRedundant) {
+          continue;
+        }
+        auto c = doMove(cubes[i], move);
+        if (!seen.insert(key(c)).second) {
+          redundant.insert(s);
+          ret.push_back(s);
+          continue;
+        }
+        nextSequences.push_back(s);
+        nextCubes.push_back(c);
+      }
+    }
+    sequences.swap(nextSequences);
+    cubes.swap(nextCubes);
+  }
+  return ret;
+}
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_MOVE_AUTOMATON_HPP_
@@ -0,0 +1,278 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_PRUNING_BFS_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_PRUNING_BFS_HPP_
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
+
+#include "cube_util/thread_pool.hpp"
+#include "cube_util/utils.hpp"
+
+namespace cube_util {
+namespace utils {
+
+using std::vector;
+
+/** Number of states scanned by each task of a breadth first search pass */
+const uint32_t kPruningChunkSize = 1 << 16;
+
+/**
+ * Get a value from a table packing values of `BITS` bits into uint16_t,
+ * which may be updated by other threads at the same time.
+ * @tparam BITS bits per value, 4 for pruning tables, 2 for distance tables
+ * storing distances modulo 3
+ * @param table the table
+ * @param index index of the value
+ * @returns the value
+ */
+template<uint16_t BITS = 4>
+inline uint16_t loadPruning(const uint16_t *table, uint32_t index) {
+  const uint16_t perWord = 16 / BITS;
+  auto word = __atomic_load_n(table + index / perWord, __ATOMIC_RELAXED);
+  return (word >> (index % perWord * BITS)) & ((1 << BITS) - 1);
+}
+
+/**
+ * Set a value into a table packing values of `BITS` bits if the current
+ * value is unknown (all bits set). It's safe to be called by multiple
+ * threads at the same time.
+ * @tparam BITS bits per value, see loadPruning()
+ * @param[inout] table the table
+ * @param index index of the value
+ * @param p the value
+ * @returns whether the value is set
+ */
+template<uint16_t BITS = 4>
+inline bool setUnknownPruning(uint16_t *table, uint32_t index, uint16_t p) {
+  const uint16_t perWord = 16 / BITS;
+  const uint16_t unknown = (1 << BITS) - 1;
+  auto word = table + index / perWord;
+  auto shift = index % perWord * BITS;
+  uint16_t old = __atomic_load_n(word, __ATOMIC_RELAXED);
+  uint16_t desired;
+  do {
+    if (((old >> shift) & unknown) != unknown) {
+      return false;
+    }
+    desired = (old & ~(unknown << shift)) | (p << shift);
+  } while (!__atomic_compare_exchange_n(word, &old, desired, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  return true;
+}
+
+/**
+ * Check whether any of the values of `BITS` bits packed in a table element
+ * equals to `p`.
+ * @tparam BITS bits per value, see loadPruning()
+ * @param word the table element
+ * @param p the value
+ * @returns whether any value equals to `p`
+ */
+template<uint16_t BITS = 4>
+inline bool hasPruning(uint16_t word, uint16_t p) {
+  // lowest and highest bit of each value
+  const uint16_t low = 0xffff / ((1 << BITS) - 1);
+  const uint16_t high = low << (BITS - 1);
+  uint16_t x = word ^ (p * low);
+  return ((x - low) & ~x & high) != 0;
+}
+
+/**
+ * Fill a table packing values of `BITS` bits with distances from the solved
+ * states by breadth first search.
+ * Each pass finds the states one move further than the last one. While few
+ * states are found, a pass expands the last found states (forward);
+ * otherwise it checks each unknown state for a neighbour found in the last
+ * pass (backward), which needs moves to be closed under inversion. Passes
+ * are split across the workers of a pool if given.
+ * With 2 bits a value is the distance modulo 3, so a forward pass also
+ * expands states 3, 6, ... moves closer than the last found ones, which
+ * only reach known states, while a backward pass can't mistake them for the
+ * last found ones, as an unknown state is more than 2 moves away from them.
+ * @tparam BITS bits per value, 4 for distances, 2 for distances modulo 3
+ * @param[out] table table of (`size` * `BITS` + 15) / 16 elements
+ * @param size number of states
+ * @param solved states of distance 0
+ * @param nMoves number of moves
+ * @param doMove function taking a state and a move index, returning the
+ * state the move leads to
+ * @param forEachEquivalent function taking a state and a function, calling
+ * the function with each state sharing the distance with the state
+ * @param pool pool to run the passes on, or nullptr to run them on the
+ * calling thread
+ */
+template<uint16_t BITS, typename MOVE, typename EQUIVALENT>
+void breadthFirstSearch(uint16_t *table, uint32_t size,
+                        const vector<uint32_t> &solved, uint16_t nMoves,
+                        const MOVE &doMove,
+                        const EQUIVALENT &forEachEquivalent,
+                        ThreadPool *pool) {
+  static_assert(BITS == 2 || BITS == 4, "values need 2 or 4 bits");
+  const uint16_t perWord = 16 / BITS;
+  const uint16_t unknown = (1 << BITS) - 1;
+  auto value = [](uint16_t depth) -> uint16_t {
+    return BITS == 2 ? depth % 3 : depth;
+  };
+  std::fill(table, table + (size + perWord - 1) / perWord, 0xffff);
+  uint32_t count = 0;
+  auto set = [table, &forEachEquivalent](uint32_t index, uint16_t p) {
+    if (!setUnknownPruning<BITS>(table, index, p)) {
+      return 0;
+    }
+    auto n = 1;
+    forEachEquivalent(index, [table, p, &n](uint32_t equivalent) {
+      n += setUnknownPruning<BITS>(table, equivalent, p);
+    });
+    return n;
+  };
+  for (auto s : solved) {
+    count += set(s, 0);
+  }
+
+  auto nChunks = (size + kPruningChunkSize - 1) / kPruningChunkSize;
+  auto found = vector<uint32_t>(pool == nullptr ? 1 : pool->size());
+  uint32_t frontier = count;
+  for (uint16_t depth = 0; count < size && frontier > 0; depth++) {
+    auto backward = size - count < frontier * 4;
+    auto last = value(depth);
+    auto next = value(depth + 1);
+    // in a backward pass unknown states are searched for
+    auto target = backward ? unknown : last;
+    std::fill(found.begin(), found.end(), 0);
+    auto scan = [&](uint32_t chunk, uint16_t worker) {
+      auto begin = chunk * kPruningChunkSize;
+      auto end = std::min(size, begin + kPruningChunkSize);
+      for (auto i = begin; i < end; i += perWord) {
+        if (!hasPruning<BITS>(__atomic_load_n(table + i / perWord,
+                                              __ATOMIC_RELAXED), target)) {
+          continue;
+        }
+        for (auto index = i; index < std::min<uint32_t>(end, i + perWord);
+             index++) {
+          if (loadPruning<BITS>(table, index) != target) {
+            continue;
+          }
+          for (auto move = 0; move < nMoves; move++) {
+            auto newIndex = doMove(index, move);
+            if (!backward) {
+              found[worker] += set(newIndex, next);
+            } else if (loadPruning<BITS>(table, newIndex) == last) {
+              found[worker] += set(index, next);
+              break;
+            }
+          }
+        }
+      }
+    };
+    if (pool == nullptr) {
+      for (uint32_t chunk = 0; chunk < nChunks; chunk++) {
+        scan(chunk, 0);
+      }
+    } else {
+      pool->run(nChunks, scan);
+    }
+    frontier = 0;
+    for (auto n : found) {
+      frontier += n;
+    }
+    count += frontier;
+  }
+}
+
+/**
+ * Generate a pruning table with breadth first search, see
+ * breadthFirstSearch() above.
+ * @param[out] table pruning table of (`size` + 3) / 4 elements
+ * @param size number of states
+ * @param solved states of pruning value 0
+ * @param nMoves number of moves
+ * @param doMove function taking a state and a move index, returning the
+ * state the move leads to
+ * @param forEachEquivalent function taking a state and a function, calling
+ * the function with each state sharing the pruning value with the state
+ * @param pool pool to run the passes on, or nullptr to run them on the
+ * calling thread
+ */
+template<typename MOVE, typename EQUIVALENT>
+void generatePruning(uint16_t *table, uint32_t size,
+                     const vector<uint32_t> &solved, uint16_t nMoves,
+                     const MOVE &doMove,
+                     const EQUIVALENT &forEachEquivalent,
+                     ThreadPool *pool = nullptr) {
+  breadthFirstSearch<4>(table, size, solved, nMoves, doMove,
+                        forEachEquivalent, pool);
+}
+
+/**
+ * Generate a pruning table with breadth first search.
+ * See generatePruning() above.
+ * @param[out] table pruning table of (`size` + 3) / 4 elements
+ * @param size number of states
+ * @param solved state of pruning value 0
+ * @param nMoves number of moves
+ * @param doMove function taking a state and a move index, returning the
+ * state the move leads to
+ * @param pool pool to run the passes on, or nullptr to run them on the
+ * calling thread
+ */
+template<typename MOVE>
+void generatePruning(uint16_t *table, uint32_t size, uint32_t solved,
+                     uint16_t nMoves, const MOVE &doMove,
+                     ThreadPool *pool = nullptr) {
+  auto noEquivalent = [](uint32_t, const auto &) {};
+  generatePruning(table, size, {solved}, nMoves, doMove, noEquivalent, pool);
+}
+
+/**
+ * Generate a distance table storing distances modulo 3, see
+ * utils::setMod3Pruning(). It takes half the memory of a pruning table, but
+ * the exact distance of a state needs to be derived from that of a
+ * neighbour. The search runs on the table itself, see breadthFirstSearch()
+ * above, so all states need to be reachable.
+ * @param[out] table distance table of (`size` + 7) / 8 elements
+ * @param size number of states
+ * @param solved states of distance 0
+ * @param nMoves number of moves
+ * @param doMove function taking a state and a move index, returning the
+ * state the move leads to
+ * @param forEachEquivalent function taking a state and a function, calling
+ * the function with each state sharing the distance with the state
+ * @param pool pool to run the passes on, or nullptr to run them on the
+ * calling thread
+ */
+template<typename MOVE, typename EQUIVALENT>
+void generateDistanceMod3(uint16_t *table, uint32_t size,
+                          const vector<uint32_t> &solved, uint16_t nMoves,
+                          const MOVE &doMove,
+                          const EQUIVALENT &forEachEquivalent,
+                          ThreadPool *pool = nullptr) {
+  breadthFirstSearch<2>(table, size, solved, nMoves, doMove,
+                        forEachEquivalent, pool);
+}
+
+/**
+ * Generate a distance table storing distances modulo 3.
+ * See generateDistanceMod3() above.
+ * @param[out] table distance table of (`size` + 7) / 8 elements
+ * @param size number of states
+ * @param solved state of distance 0
+ * @param nMoves number of moves
+ * @param doMove function taking a state and a move index, returning the
+ * state the move leads to
+ * @param pool pool to run the passes on, or nullptr to run them on the
+ * calling thread
+ */
+template<typename MOVE>
+void generateDistanceMod3(uint16_t *table, uint32_t size, uint32_t solved,
+                          uint16_t nMoves, const MOVE &doMove,
+                          ThreadPool *pool = nullptr) {
+  auto noEquivalent = [](uint32_t, const auto &) {};
+  generateDistanceMod3(table, size, {solved}, nMoves, doMove, noEquivalent,
+                       pool);
+}
+
+}  // namespace utils
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_PRUNING_BFS_HPP_
@@ -0,0 +1,144 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_PUZZLE_COORD_CUBE_333_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_PUZZLE_COORD_CUBE_333_HPP_
+#include <cstdint>
+
+#include <array>
+#include <vector>
+
+#include "cube_util/move_sequence.hpp"
+#include "cube_util/puzzle/cubie_cube_333.hpp"
+#include "cube_util/utils.hpp"
+
+namespace cube_util {
+
+using std::array;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A class representing a 3x3x3 cube model by coordinates.
+/// It holds the corner orientation, edge orientation and corner permutation
+/// coordinates, and the positions and permutation coordinate of each group of
+/// 4 edges (see CubieCube333::getEdge4Index()), which together describe the
+/// whole state. A move costs one move table lookup per coordinate instead of
+/// a CubieCube333 multiplication and ranking the permutations again.
+/// It is only converted back to a CubieCube333 by toCubieCube().
+////////////////////////////////////////////////////////////////////////////////
+class CoordCube333 {
+  /** Corner orientation coordinate */
+  uint16_t twist_ = cube333::kSolvedTwist;
+
+  /** Edge orientation coordinate */
+  uint16_t flip_ = cube333::kSolvedFlip;
+
+  /** Corner permutation coordinate */
+  uint16_t cp_ = cube333::kSolvedCp;
+
+  /** Positions and permutation coordinate of each edge group */
+  array<uint16_t, 3> edge4_ = {cube333::kSolvedUEdge4, cube333::kSolvedDEdge4,
+                               cube333::kSolvedSliceEdge4};
+
+ public:
+  /**
+   * The default constructor, giving the solved state.
+   */
+  CoordCube333() = default;
+
+  /**
+   * Constructor of the class.
+   * @param cc the cube to take the coordinates of
+   */
+  explicit CoordCube333(const CubieCube333 &cc);
+
+  /**
+   * Apply a move to the cube.
+   * @param move the move to apply
+   */
+  void move(uint16_t move);  // NOLINT(build/include_what_you_use)
+
+  /**
+   * Apply moves to the cube in order.
+   * @param moves the moves to apply
+   */
+  void applySequence(const vector<uint16_t> &moves);
+
+  /**
+   * Apply a move sequence to the cube.
+   * @param sequence the sequence to apply
+   */
+  void applySequence(const MoveSequence &sequence);
+
+  /**
+   * Get the corner orientation coordinate.
+   * @returns the coordinate
+   */
+  uint16_t getTwist() const;
+
+  /**
+   * Get the edge orientation coordinate.
+   * @returns the coordinate
+   */
+  uint16_t getFlip() const;
+
+  /**
+   * Get the corner permutation coordinate.
+   * @returns the coordinate
+   */
+  uint16_t getCP() const;
+
+  /**
+   * Get the positions and permutation coordinate of a group of 4 edges.
+   * @param group the edge group, see cube333::EdgeGroups
+   * @returns the coordinate
+   */
+  uint16_t getEdge4(uint16_t group) const;
+
+  /**
+   * Get the E-slice edges positions coordinate.
+   * @returns the coordinate
+   */
+  uint16_t getSlicePosition() const;
+
+  /**
+   * Get the E-slice edges permutation coordinate, only meaningful when
+   * phase1 is solved.
+   * @returns the coordinate
+   */
+  uint16_t getSliceEP() const;
+
+  /**
+   * Get the UD 8 edges permutation coordinate, only valid when phase1 is
+   * solved.
+   * @returns the coordinate
+   */
+  uint16_t getUD8EP() const;
+
+  /**
+   * Check if the cube is in the phase2 subgroup <U, D, L2, R2, F2, B2>.
+   * @returns true if phase1 is solved, false otherwise
+   */
+  bool isPhase1Solved() const;
+
+  /**
+   * Check if the cube is solved.
+   * @returns true if solved, false otherwise
+   */
+  bool isSolved() const;
+
+  /**
+   * Convert the cube to cubie level.
+   * @returns a CubieCube333 of the same state
+   */
+  CubieCube333 toCubieCube() const;
+
+  /**
+   * Check if `this` is identical to `that`.
+   * @param that another CoordCube333
+   * @returns true if `this` is identical to `that`, false otherwise
+   */
+  bool operator==(const CoordCube333 &that) const;
+};
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_PUZZLE_COORD_CUBE_333_HPP_
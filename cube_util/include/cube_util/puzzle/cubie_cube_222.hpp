@@ -4,6 +4,7 @@
 #include <string>
 
 #include "cube_util/puzzle/cubie_cube_nnn.hpp"
+#include "cube_util/random.hpp"
 
 namespace cube_util {
 
@@ -74,6 +75,13 @@ class CubieCube222 : public CubieCubeNNN {
    */
   static CubieCube222 randomCube();
 
+  /**
+   * Get a cube in random position.
+   * @param random the random engine to use
+   * @returns a CubieCube222 with random state
+   */
+  static CubieCube222 randomCube(RandomEngine *random);
+
   /**
    * Get a new CubieCube222 model with specified move applied to
    * an identity cube. This is used to calculate new cube states.
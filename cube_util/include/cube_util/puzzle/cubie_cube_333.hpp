@@ -4,6 +4,7 @@
 #include <string>
 
 #include "cube_util/puzzle/cubie_cube_nnn.hpp"
+#include "cube_util/random.hpp"
 
 namespace cube_util {
 
@@ -61,6 +62,14 @@ class CubieCube333 : public CubieCubeNNN {
    */
   void setSlicePosition(uint16_t index);
 
+  /**
+   * Set positions and permutation of a group of 4 edges according to given
+   * index, see getEdge4Index().
+   * @param group the edge group, see cube333::EdgeGroups
+   * @param index specified index
+   */
+  void setEdge4(uint16_t group, uint16_t index);
+
   /**
    * Calculate product (_one_ * _another_) of two cubes.
    * @param[in] one the first cube
@@ -70,6 +79,50 @@ class CubieCube333 : public CubieCubeNNN {
   static void cubeMult(const CubieCube333 &one, const CubieCube333 &another,
                        CubieCube333 *result);
 
+  /**
+   * Calculate product (_one_ * _another_) of two cubes, either of which
+   * may be mirrored. Corner orientations of a mirrored cube are stored as
+   * 3 to 5.
+   * @param[in] one the first cube
+   * @param[in] another the second cube
+   * @param[out] result pointer to a cube to return the result to
+   */
+  static void symMult(const CubieCube333 &one, const CubieCube333 &another,
+                      CubieCube333 *result);
+
+  /**
+   * Get the cube representing one of the 16 symmetries preserving the UD
+   * axis. Symmetry `sym` = 8 * `f2` + 2 * `u4` + `lr2`, which is the
+   * product of `f2` z2 rotations, `u4` y rotations and `lr2` L-R mirrors.
+   * @param sym the symmetry index
+   * @returns the symmetry cube
+   */
+  static const CubieCube333& getSymCube(uint16_t sym);
+
+  /**
+   * Get the inverse of a symmetry.
+   * @param sym the symmetry index
+   * @returns index of the inverse symmetry
+   */
+  static uint16_t getSymInverse(uint16_t sym);
+
+  /**
+   * Calculate flip-slice coordinate of S^-1 * C * S, where C is a cube with
+   * specified flip-slice coordinate and S is the cube of symmetry `sym`.
+   * @param flipSlice `flip` * cube333::kNSlicePosition + `slice` of C
+   * @param sym the symmetry index
+   * @returns the conjugated flip-slice coordinate
+   */
+  static uint32_t getFlipSliceConj(uint32_t flipSlice, uint16_t sym);
+
+  /**
+   * Get the cube of a rotation around the URF-DBL diagonal, which takes the
+   * U face to R, R to F and F to U.
+   * @param times how many times to rotate, less than cube333::kNURFRotation
+   * @returns the rotation cube
+   */
+  static const CubieCube333& getURFCube(uint16_t times);
+
  public:
   CubieCube333();
 
@@ -121,6 +174,18 @@ class CubieCube333 : public CubieCubeNNN {
    */
   uint16_t getSliceEPIndex() const;
 
+  /**
+   * Calculate positions and permutation index of a group of 4 edges.
+   * `index` = `comb` * 24 + `perm`, where `comb` is the combination index
+   * of their positions and `perm` is the permutation index of their order.
+   * Unlike the UD 8 edges and E-slice permutation indices, it is defined for
+   * any state, and getSliceEPIndex() equals it modulo 24 once phase1 is
+   * solved.
+   * @param group the edge group, see cube333::EdgeGroups
+   * @returns the index, less than cube333::kNEdge4
+   */
+  uint16_t getEdge4Index(uint16_t group) const;
+
   string toString() const override;
 
   FaceletCubeNNN toFaceletCube() const override;
@@ -146,12 +211,26 @@ class CubieCube333 : public CubieCubeNNN {
    */
   static CubieCube333 randomCube();
 
+  /**
+   * Get a cube in random position.
+   * @param random the random engine to use
+   * @returns a CubieCube333 with random state
+   */
+  static CubieCube333 randomCube(RandomEngine *random);
+
   /**
    * Get a cube with phase1 solved in random position.
    * @returns a random CubieCube333 with phase1 solved
    */
   static CubieCube333 randomDRCube();
 
+  /**
+   * Get a cube with phase1 solved in random position.
+   * @param random the random engine to use
+   * @returns a random CubieCube333 with phase1 solved
+   */
+  static CubieCube333 randomDRCube(RandomEngine *random);
+
   /**
    * Get a new CubieCube333 model with specified move applied to
    * an identity cube. This is used to calculate new cube states.
@@ -186,6 +265,32 @@ class CubieCube333 : public CubieCubeNNN {
   static uint16_t getSlicePositionMove(uint16_t slicePositionIndex,
                                        uint16_t move);
 
+  /**
+   * Get new twist coordinates by applying each of the 18 moves to specified
+   * twist coordinate. They are stored next to each other, so all children of
+   * a search node can be loaded at once.
+   * @param twist the original twist coordinate
+   * @returns new twist coordinates indexed by move
+   */
+  static const array<uint16_t, kNMove>& getTwistMoves(uint16_t twist);
+
+  /**
+   * Get new flip coordinates by applying each of the 18 moves to specified
+   * flip coordinate.
+   * @param flip the original flip coordinate
+   * @returns new flip coordinates indexed by move
+   */
+  static const array<uint16_t, kNMove>& getFlipMoves(uint16_t flip);
+
+  /**
+   * Get new E-slice edges positions coordinates by applying each of the 18
+   * moves to specified original coordinate.
+   * @param slicePositionIndex the original E-slice edges positions coordinate
+   * @returns new E-slice edges positions coordinates indexed by move
+   */
+  static const array<uint16_t, kNMove>& getSlicePositionMoves(
+      uint16_t slicePositionIndex);
+
   /**
    * Get new UD 8 edges positions coordinate by applying a move to
    * specified original coordinate.
@@ -204,6 +309,35 @@ class CubieCube333 : public CubieCubeNNN {
    */
   static uint16_t getCPMove(uint16_t cp, uint16_t index);
 
+  /**
+   * Get new corner permutation coordinate by applying any of the 18 moves
+   * to specified corner permutation coordinate.
+   * @param cp the original corner permutation coordinate
+   * @param move the move to apply
+   * @returns new corner permutation coordinate
+   */
+  static uint16_t getFullCPMove(uint16_t cp, uint16_t move);
+
+  /**
+   * Get new positions and permutation coordinate of a group of 4 edges by
+   * applying a move to specified original coordinate. The same table
+   * serves all edge groups.
+   * @param edge4 the original coordinate, see getEdge4Index()
+   * @param move the move to apply
+   * @returns new positions and permutation coordinate
+   */
+  static uint16_t getEdge4Move(uint16_t edge4, uint16_t move);
+
+  /**
+   * Get the UD 8 edges permutation coordinate of a cube with phase1 solved
+   * from the coordinates of its U edges and D edges.
+   * @param uEdge4 positions and permutation coordinate of the U edges, less
+   * than cube333::kNUd8Edge4 as phase1 is solved
+   * @param dEdge4 positions and permutation coordinate of the D edges
+   * @returns the UD 8 edges permutation coordinate
+   */
+  static uint16_t getUD8EPFromEdge4(uint16_t uEdge4, uint16_t dEdge4);
+
   /**
    * Get new slice edge permutation coordinate by applying a move to
    * specified slice edge permutation coordinate.
@@ -213,6 +347,68 @@ class CubieCube333 : public CubieCubeNNN {
    */
   static uint16_t getSliceEPMove(uint16_t sliceEP, uint16_t index);
 
+  /**
+   * Get twist coordinate of S * C * S^-1, where C is a cube with specified
+   * twist and S is the cube of symmetry `sym`.
+   * @param twist the twist coordinate of C
+   * @param sym the symmetry index, less than cube333::kNSymD4h
+   * @returns the conjugated twist coordinate
+   */
+  static uint16_t getTwistConj(uint16_t twist, uint16_t sym);
+
+  /**
+   * Get the symmetry-reduced flip-slice coordinate of a flip and E-slice
+   * edges positions combination. Every combination X is written as
+   * S^-1 * R * S, where R is the representative of its equivalence class
+   * and S is a symmetry.
+   * @param flip the flip coordinate
+   * @param slice the E-slice edges positions coordinate
+   * @returns `class` * cube333::kNSymD4h + `sym`, where `class` is index of
+   * the equivalence class and `sym` is index of S
+   */
+  static uint32_t getFlipSliceSym(uint16_t flip, uint16_t slice);
+
+  /**
+   * Get the representative of a flip-slice equivalence class.
+   * @param flipSliceClass index of the equivalence class
+   * @returns `flip` * cube333::kNSlicePosition + `slice` of the
+   * representative
+   */
+  static uint32_t getFlipSliceRep(uint16_t flipSliceClass);
+
+  /**
+   * Get symmetries leaving the representative of a flip-slice equivalence
+   * class unchanged.
+   * @param flipSliceClass index of the equivalence class
+   * @returns bit mask with bit `sym` set for each such symmetry
+   */
+  static uint16_t getFlipSliceSelfSym(uint16_t flipSliceClass);
+
+  /**
+   * Get the inverse of the cube.
+   * @returns the cube solved by applying `this` to it
+   */
+  CubieCube333 inverse() const;
+
+  /**
+   * Get the cube conjugated by a rotation around the URF-DBL diagonal.
+   * The result is S^-1 * C * S, where C is `this` and S is the rotation
+   * taking the U face to R, R to F and F to U, applied `times` times.
+   * @param times how many times to rotate, less than cube333::kNURFRotation
+   * @returns the conjugated cube
+   */
+  CubieCube333 rotateURF(uint16_t times) const;
+
+  /**
+   * Get the move M' = S * M * S^-1, where M is `move` and S is the rotation
+   * used by rotateURF(). A sequence solving rotateURF(`times`) is mapped by
+   * this function to a sequence solving the original cube.
+   * @param move the move to conjugate
+   * @param times how many times to rotate, less than cube333::kNURFRotation
+   * @returns the conjugated move
+   */
+  static uint16_t getURFMoveConj(uint16_t move, uint16_t times);
+
   /**
    * Check if `this` is identical to `that`.
    * @param that another CubieCube333
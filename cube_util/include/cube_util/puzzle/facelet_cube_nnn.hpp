@@ -3,6 +3,8 @@
 #define CUBE_UTIL_INCLUDE_CUBE_UTIL_PUZZLE_FACELET_CUBE_NNN_HPP_
 #include <cstdint>
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -23,14 +25,118 @@ class FaceletCubeNNN {
   /// Size of the cube.
   /// Currently supports from 2 to #constants::kMaxSize.
   uint16_t size_;
-  /** Facelets definitions of the cube. */
-  vector<uint16_t> facelets_;
+  /** Facelets definitions of the cube, one byte each. */
+  vector<uint8_t> facelets_;
+
+  /**
+   * A hash computed on first use, copied along with the cube. Its members
+   * are atomic, so that threads calling hash() on the same const cube at
+   * the same time, which all compute the same value, do not race.
+   */
+  class CachedHash {
+    std::atomic<uint64_t> value_{0};
+    std::atomic<bool> computed_{false};
+
+   public:
+    CachedHash() = default;
+
+    CachedHash(const CachedHash &that) {
+      *this = that;
+    }
+
+    CachedHash& operator=(const CachedHash &that) {
+      auto computed = that.computed_.load(std::memory_order_acquire);
+      value_.store(that.value_.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+      computed_.store(computed, std::memory_order_release);
+      return *this;
+    }
+
+    /** @returns whether the value is computed */
+    bool computed() const {
+      return computed_.load(std::memory_order_acquire);
+    }
+
+    /** @returns the value, valid if computed() */
+    uint64_t value() const {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set the value and mark it computed.
+     * @param value the value
+     */
+    void set(uint64_t value) {
+      value_.store(value, std::memory_order_relaxed);
+      computed_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * XOR a change into the value. It's only called by the owner of a cube
+     * while changing it, so it needs no atomic read-modify-write.
+     * @param change the change
+     */
+    void update(uint64_t change) {
+      value_.store(value() ^ change, std::memory_order_relaxed);
+    }
+
+    /** Mark the value not computed */
+    void clear() {
+      computed_.store(false, std::memory_order_relaxed);
+    }
+  };
+
+  /**
+   * Zobrist hash of #facelets_, see hash(). It's computed on the first call
+   * of hash() and kept by moves from then on, while cubes never hashed skip
+   * the updates.
+   */
+  mutable CachedHash hash_;
 
   /**
    * Outputs info about the cube, includes size and facelets.
    */
   friend std::ostream& operator<<(std::ostream& os, const FaceletCubeNNN &fc);
 
+  /**
+   * Turn the outer _shift_ layers of a face clockwise for _amount_ times,
+   * moving the side facelets by a permutation computed once per size and
+   * move, and rotating the faces turned as a whole.
+   * @param face the face to turn
+   * @param shift how many layers to turn, from 1 to #size_
+   * @param amount how many times to turn, any amount
+   */
+  void turn(uint16_t face, int shift, int amount);
+
+  /**
+   * Rotate a face clockwise for _amount_ times, keeping #hash_.
+   * @param face the face to rotate
+   * @param amount how many times to turn, from 1 to 3
+   */
+  void turnFace(uint16_t face, int amount);
+
+  /**
+   * Turn a single layer clockwise for _amount_ times, keeping #hash_ by the
+   * keys of the facelets of the layer only.
+   * @param face the face whose axis to turn
+   * @param layer which layer to turn, counting from 1 from the face
+   * @param amount how many times to turn, any positive amount
+   */
+  void turnOneLayer(uint16_t face, int layer, int amount);
+
+  /**
+   * Get the XOR of the Zobrist keys of the facelets of a face.
+   * @param face the face
+   * @returns the keys of the face
+   */
+  uint64_t faceKeys(uint16_t face) const;
+
+  /**
+   * Check whether the cube is solved.
+   * @returns whether every face has a single colour, of the face itself
+   */
+  bool isSolved() const;
+
  public:
   /**
    * Constructor of the class.
@@ -43,7 +149,8 @@ class FaceletCubeNNN {
    * Constructor of the class.
    * @param size size of the cube, currently supports
    * from 2 to #constants::kMaxSize
-   * @param facelets definition of the current facelets state
+   * @param facelets definition of the current facelets state, colours
+   * from 0 to 5
    */
   FaceletCubeNNN(uint16_t size, const vector<uint16_t> &facelets);
 
@@ -55,7 +162,7 @@ class FaceletCubeNNN {
 
   /**
    * Get current facelets status.
-   * @returns a copy of #facelets_
+   * @returns a copy of #facelets_ widened to 16 bits
    */
   vector<uint16_t> getFacelets() const;
 
@@ -245,13 +352,26 @@ class FaceletCubeNNN {
 
   /**
    * Check whether the cube is solvable within given length.
-   * @param max_length max length to attempt
+   * Only the moves whose layers hold all the facelets out of place, together
+   * with the layers of one more move for length 2, are tried.
+   * @param max_length max length to attempt, at most 2
    * @returns whether the cube is solvable within given length
    */
   bool isSolvableIn(uint16_t max_length) const;
 
   /**
-   * Check if `this` is identical to `that`.
+   * Get the Zobrist hash of the current state, the XOR of an independent
+   * random key for every facelet and its colour. It's computed on the first
+   * call, and from then on moves update it by the facelets they change, so
+   * cubes never hashed do not pay for it. Like other const methods, it may
+   * be called by several threads at the same time.
+   * @returns the hash, equal for identical cubes of the same size
+   */
+  uint64_t hash() const;
+
+  /**
+   * Check if `this` is identical to `that`, first comparing their hashes if
+   * both are computed.
    * @param that another FaceCubeNNN
    * @returns true if `this` is identical to `that`, false otherwise
    */
@@ -260,4 +380,16 @@ class FaceletCubeNNN {
 
 }  // namespace cube_util
 
+namespace std {
+
+/** Hash of a cube, for unordered containers of cube states */
+template<>
+struct hash<cube_util::FaceletCubeNNN> {
+  size_t operator()(const cube_util::FaceletCubeNNN &fc) const {
+    return fc.hash();
+  }
+};
+
+}  // namespace std
+
 #endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_PUZZLE_FACELET_CUBE_NNN_HPP_
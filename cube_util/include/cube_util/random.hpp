@@ -0,0 +1,113 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_RANDOM_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_RANDOM_HPP_
+#include <cstdint>
+
+#include <array>
+
+namespace cube_util {
+
+using std::array;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A source of random numbers for random state generators and scramblers.
+/// Implementations only need to provide next(). Instances are not thread
+/// safe, each thread should use its own.
+////////////////////////////////////////////////////////////////////////////////
+class RandomEngine {
+ public:
+  /**
+   * Get the next random number.
+   * @returns a uniformly distributed 64-bit number
+   */
+  virtual uint64_t next() = 0;
+
+  /**
+   * Get a uniformly distributed random number in [0, `bound`).
+   * @param bound upper bound of the number (exclusive), greater than 0
+   * @returns the random number
+   */
+  uint64_t uniform(uint64_t bound);
+
+  virtual ~RandomEngine() = default;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// The xoshiro256** generator by David Blackman and Sebastiano Vigna.
+/// It's fast, has a period of 2^256 - 1 and passes all known statistical
+/// tests. It also meets the requirements of UniformRandomBitGenerator, so it
+/// works with distributions of the standard library.
+////////////////////////////////////////////////////////////////////////////////
+class Xoshiro256 : public RandomEngine {
+  /** The generator state */
+  array<uint64_t, 4> state_;
+
+ public:
+  using result_type = uint64_t;
+
+  /**
+   * Constructor of the class.
+   * @param seed the seed, expanded to the whole state with splitmix64
+   */
+  explicit Xoshiro256(uint64_t seed);
+
+  /**
+   * Reset the generator with a seed.
+   * @param seed the seed, expanded to the whole state with splitmix64
+   */
+  void seed(uint64_t seed);
+
+  uint64_t next() override;
+
+  /**
+   * Get the next random number.
+   * @returns a uniformly distributed 64-bit number
+   */
+  uint64_t operator()() {
+    return next();
+  }
+
+  /**
+   * Get the smallest number the generator returns.
+   * @returns 0
+   */
+  static constexpr uint64_t min() {
+    return 0;
+  }
+
+  /**
+   * Get the largest number the generator returns.
+   * @returns 2^64 - 1
+   */
+  static constexpr uint64_t max() {
+    return UINT64_MAX;
+  }
+};
+
+/**
+ * Derive a seed from another seed and a key, e.g. a seed for each of many
+ * streams from one master seed. Different keys give unrelated seeds.
+ * @param seed the seed to derive from
+ * @param key the key
+ * @returns the derived seed
+ */
+uint64_t deriveSeed(uint64_t seed, uint64_t key);
+
+/**
+ * Get the random engine of the calling thread, used wherever no engine is
+ * given explicitly. Each thread gets its own engine, seeded from
+ * `std::random_device` on first use.
+ * @returns the engine of the calling thread
+ */
+RandomEngine& threadRandomEngine();
+
+/**
+ * Seed the random engine of the calling thread, so that the random states
+ * and scrambles it generates later are reproducible.
+ * @param seed the seed
+ */
+void seedThreadRandomEngine(uint64_t seed);
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_RANDOM_HPP_
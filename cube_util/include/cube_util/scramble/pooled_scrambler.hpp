@@ -0,0 +1,178 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_SCRAMBLE_POOLED_SCRAMBLER_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_SCRAMBLE_POOLED_SCRAMBLER_HPP_
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cube_util/bounded_queue.hpp"
+#include "cube_util/scramble/scrambler.hpp"
+
+namespace cube_util {
+
+using std::atomic;
+using std::condition_variable;
+using std::exception_ptr;
+using std::function;
+using std::mutex;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A scrambler generating scrambles ahead of time in background threads.
+/// Each producer thread owns a scrambler and keeps a bounded lock-free queue
+/// of ready scrambles topped up, so scramble() only has to pop one, and it
+/// only generates inline when the queue runs empty. scramble() can be called
+/// from multiple threads at the same time. A producer whose scrambler throws
+/// stops, see Metrics::failedProducers.
+///
+/// The scrambles depend on the thread engines of the producers, see
+/// threadRandomEngine(), so they are not reproducible, use
+/// Scrambler::scrambleAt() for that.
+////////////////////////////////////////////////////////////////////////////////
+class PooledScrambler {
+ public:
+  /** Counters of the pool, see getMetrics() */
+  struct Metrics {
+    /** Scrambles ready in the queue */
+    size_t size;
+
+    /** Max number of scrambles in the queue */
+    size_t capacity;
+
+    /** Least number of scrambles left in the queue after a scramble() call */
+    size_t lowWaterMark;
+
+    /** Scrambles generated by the producers */
+    uint64_t produced;
+
+    /** Scrambles returned by scramble(), including inline ones */
+    uint64_t served;
+
+    /** Scrambles scramble() had to generate inline */
+    uint64_t fallbacks;
+
+    /**
+     * Producers stopped by an exception from their scrambler, never cleared
+     * by resetMetrics()
+     */
+    uint16_t failedProducers;
+
+    /**
+     * Scrambles per second the producers still running generate together
+     * while busy, i.e. how fast an empty queue gets refilled
+     */
+    double refillRate;
+  };
+
+  /**
+   * Constructor of the class. The producers start right away.
+   * @param factory function creating a scrambler for each producer and for
+   * inline generation
+   * @param capacity max number of ready scrambles
+   * @param nThreads number of producer threads,
+   * 0 means the number of hardware threads
+   */
+  PooledScrambler(function<unique_ptr<Scrambler>()> factory, size_t capacity,
+                  uint16_t nThreads = 1);
+
+  /**
+   * Constructor of the class, pooling scramblers of Scrambler::instance().
+   * @param size size of the cube
+   * @param capacity max number of ready scrambles
+   * @param nThreads number of producer threads,
+   * 0 means the number of hardware threads
+   */
+  PooledScrambler(uint16_t size, size_t capacity, uint16_t nThreads = 1);
+
+  PooledScrambler(const PooledScrambler &) = delete;
+
+  PooledScrambler& operator=(const PooledScrambler &) = delete;
+
+  /**
+   * Destructor of the class. Stops the producers, waiting for the scrambles
+   * in progress to finish.
+   */
+  ~PooledScrambler();
+
+  /**
+   * Get a ready scramble, or generate one inline if there is none. Once all
+   * the producers have failed, an empty queue rethrows the first exception
+   * they threw instead.
+   * @returns the scramble sequence
+   */
+  unique_ptr<MoveSequence> scramble();
+
+  /**
+   * Get the current counters of the pool.
+   * @returns the metrics
+   */
+  Metrics getMetrics() const;
+
+  /**
+   * Reset the low-water mark to the current queue size and clear the other
+   * counters.
+   */
+  void resetMetrics();
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  /** Creates scramblers */
+  function<unique_ptr<Scrambler>()> factory_;
+
+  /** Ready scrambles */
+  BoundedQueue<unique_ptr<MoveSequence>> queue_;
+
+  /** Producer threads */
+  vector<thread> threads_;
+
+  /** Guards sleeping of producers */
+  mutex mutex_;
+
+  /** Signals producers that the queue has room or stopping is requested */
+  condition_variable wake_;
+
+  /** Whether the pool is being destroyed */
+  atomic<bool> stopping_;
+
+  /** Number of producers waiting for room in the queue */
+  atomic<uint16_t> sleeping_;
+
+  /** See Metrics */
+  atomic<size_t> low_water_mark_;
+
+  /** See Metrics */
+  atomic<uint64_t> produced_;
+
+  /** See Metrics */
+  atomic<uint64_t> served_;
+
+  /** See Metrics */
+  atomic<uint64_t> fallbacks_;
+
+  /** Time the producers spent generating, in nanoseconds */
+  atomic<uint64_t> busy_nanos_;
+
+  /** See Metrics */
+  atomic<uint16_t> failed_producers_;
+
+  /** First exception thrown by a producer, guarded by #mutex_ */
+  exception_ptr error_;
+
+  void produce();
+};
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_SCRAMBLE_POOLED_SCRAMBLER_HPP_
@@ -6,9 +6,11 @@
 #include <memory>
 
 #include "cube_util/move_sequence.hpp"
+#include "cube_util/random.hpp"
 
 namespace cube_util {
 
+using std::shared_ptr;
 using std::unique_ptr;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -31,9 +33,50 @@ class Scrambler {
 
   virtual ~Scrambler() = default;
 
+  /**
+   * Set the random engine to generate scrambles with. A scrambler with its
+   * own engine must not be used by multiple threads at the same time.
+   * @param random the engine, or nullptr to use the engine of the calling
+   * thread, see threadRandomEngine()
+   */
+  void setRandomEngine(shared_ptr<RandomEngine> random);
+
+  /**
+   * Generate scrambles with a new Xoshiro256 engine seeded with `seed`, so
+   * that the same sequence of scrambles is generated for the same seed.
+   * @param seed the seed
+   */
+  void seed(uint64_t seed);
+
+  /**
+   * Generate scramble `index` of scramble set `set`. The scramble only
+   * depends on `masterSeed`, `set` and `index`, so a scramble set can be
+   * generated in shards by any number of threads or processes, each with
+   * its own scrambler, and still be identical to a serial run. The random
+   * engine of the scrambler is neither used nor changed.
+   * @param masterSeed seed of all scramble sets
+   * @param set index of the scramble set
+   * @param index index of the scramble in the set
+   * @returns the scramble sequence
+   */
+  unique_ptr<MoveSequence> scrambleAt(uint64_t masterSeed, uint64_t set,
+                                      uint64_t index);
+
   static unique_ptr<Scrambler> instance(uint16_t size);
 
  protected:
+  /**
+   * Random engine to generate scrambles with, or nullptr to use the engine
+   * of the calling thread
+   */
+  shared_ptr<RandomEngine> random_;
+
+  /**
+   * Get the random engine to generate scrambles with.
+   * @returns pointer to the engine
+   */
+  RandomEngine* random() const;
+
   /** Whether to check the scramble state to satisfy WCA regulations */
   bool wca_check_ = true;
 
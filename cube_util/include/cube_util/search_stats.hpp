@@ -0,0 +1,124 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_SEARCH_STATS_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_SEARCH_STATS_HPP_
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+
+namespace cube_util {
+
+using std::array;
+
+/**
+ * Whether solvers collect search statistics. It's turned on by defining
+ * `CUBE_UTIL_SEARCH_STATS`, e.g. with the CMake option of the same name.
+ * Otherwise all counting is compiled out and statistics stay zero.
+ */
+#ifdef CUBE_UTIL_SEARCH_STATS
+const bool kSearchStatsEnabled = true;
+#else
+const bool kSearchStatsEnabled = false;
+#endif
+
+/** Max search depth statistics are recorded for */
+const uint16_t kMaxStatsDepth = 32;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Statistics of the last search of a solver.
+/// For 2x2x2 cubes, the whole search is counted as phase 1.
+////////////////////////////////////////////////////////////////////////////////
+struct SearchStats {
+  /** Phase 1 nodes expanded at each depth */
+  array<uint64_t, kMaxStatsDepth> phase1Nodes = {};
+
+  /** Phase 2 nodes expanded at each depth, counted from the phase 2 root */
+  array<uint64_t, kMaxStatsDepth> phase2Nodes = {};
+
+  /** Number of pruning table lookups */
+  uint64_t pruningLookups = 0;
+
+  /** Number of phase 1 solutions passed on to phase 2 */
+  uint64_t phase2Entries = 0;
+
+  /** Number of phase 1 solutions rejected before searching phase 2 */
+  uint64_t phase2Rejections = 0;
+
+  /** Number of phase 1 lengths tried */
+  uint32_t phase1Lengths = 0;
+
+  /** Wall time of the whole search in seconds */
+  double seconds = 0;
+
+  /**
+   * Time threads spent searching in seconds. It equals #seconds unless
+   * phase 1 is searched on a thread pool, when it adds up the time of each
+   * thread instead of the wall time the pool runs.
+   */
+  double searchSeconds = 0;
+
+  /**
+   * Time threads spent searching phase 2 in seconds, adding up over threads
+   * as #searchSeconds does.
+   */
+  double phase2Seconds = 0;
+
+  /**
+   * Get time threads spent searching phase 1, adding up over threads as
+   * #searchSeconds does.
+   * @returns the time in seconds
+   */
+  double phase1Seconds() const;
+
+  /**
+   * Get total number of nodes expanded.
+   * @returns number of nodes in both phases
+   */
+  uint64_t nodes() const;
+
+  /**
+   * Add up statistics of another search.
+   * @param other the statistics to add
+   * @returns reference to this object
+   */
+  SearchStats& operator+=(const SearchStats &other);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Adds the wall time of its lifetime to a counter when statistics are
+/// enabled, and does nothing otherwise.
+////////////////////////////////////////////////////////////////////////////////
+class StatsTimer {
+  /** The counter to add to */
+  double *seconds_;
+
+  /** Time the timer was created */
+  std::chrono::steady_clock::time_point start_;
+
+ public:
+  /**
+   * Constructor of the class.
+   * @param[inout] seconds the counter to add to
+   */
+  explicit StatsTimer(double *seconds) : seconds_(seconds) {
+    if (kSearchStatsEnabled) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  StatsTimer(const StatsTimer &) = delete;
+
+  StatsTimer& operator=(const StatsTimer &) = delete;
+
+  ~StatsTimer() {
+    if (kSearchStatsEnabled) {
+      std::chrono::duration<double> d =
+          std::chrono::steady_clock::now() - start_;
+      *seconds_ += d.count();
+    }
+  }
+};
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_SEARCH_STATS_HPP_
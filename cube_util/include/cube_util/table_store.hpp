@@ -0,0 +1,185 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_TABLE_STORE_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_TABLE_STORE_HPP_
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cube_util {
+
+using std::function;
+using std::string;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Persisting generated tables.
+/// When a table directory is set, each table is stored there in a file with
+/// a header recording the format version, table name, dimensions and a
+/// checksum of the content. The checksum is checked when the file is
+/// written. Later processes map the file into memory instead of generating
+/// the table again. Only the header and file size are checked then, so that
+/// loading doesn't read the whole table, unless verification is enabled, see
+/// setVerifyTables(). Files that are missing or don't match the table being
+/// loaded are (re)generated.
+////////////////////////////////////////////////////////////////////////////////
+namespace tables {
+
+/**
+ * Version of the table file format. It needs to be bumped whenever the
+ * content of any table changes without changing its dimensions.
+ */
+const uint32_t kTableFormatVersion = 1;
+
+/** Max length of a table name */
+const size_t kMaxTableNameLength = 31;
+
+/** Tables at least this large are backed by huge pages when enabled */
+const size_t kHugePageSize = 2 << 20;
+
+/** Information of a loaded table */
+struct TableInfo {
+  /** Name of the table */
+  string name;
+  /** Memory used by the table in bytes */
+  size_t bytes;
+  /**
+   * Time used to load the table in seconds, including loading other tables
+   * it depends on
+   */
+  double seconds;
+  /** Whether the table is mapped from a file rather than generated */
+  bool mapped;
+  /** Whether the table is kept in memory advised to use huge pages */
+  bool hugePages;
+};
+
+/**
+ * Set the directory to store table files in.
+ * It's initialized with environment variable `CUBE_UTIL_TABLE_DIR`.
+ * Tables already loaded are not affected.
+ * @param directory path of the directory, or an empty string to always
+ * generate tables in memory
+ */
+void setTableDirectory(const string &directory);
+
+/**
+ * Get the directory to store table files in.
+ * @returns path of the directory, or an empty string if tables are not
+ * persisted
+ */
+string getTableDirectory();
+
+/**
+ * Back tables of at least #kHugePageSize bytes by huge pages, so that random
+ * lookups into them miss the TLB much less often. Such tables are kept in
+ * anonymous memory advised to use transparent huge pages, and tables mapped
+ * from files are copied there, so they are no longer shared between
+ * processes. Of the solver tables only the distance table of symmetry
+ * reduced flip, slice and twist, about 35MB, is that large; the other move
+ * and pruning tables, including the 3x3x3 corner permutation and UD edge
+ * permutation pruning tables of about 480KB each, are left as they are.
+ * It's initialized with environment variable
+ * `CUBE_UTIL_HUGE_PAGES` set to a value other than `0`. Tables already
+ * loaded are not affected.
+ * @param enabled whether to use huge pages
+ */
+void setHugePages(bool enabled);
+
+/**
+ * Get whether tables are backed by huge pages, see setHugePages().
+ * @returns whether to use huge pages
+ */
+bool getHugePages();
+
+/**
+ * Check the content of table files against their checksums when loading
+ * them, which reads every page of the tables. It's initialized with
+ * environment variable `CUBE_UTIL_VERIFY_TABLES` set to a value other than
+ * `0`. Tables already loaded are not affected.
+ * @param enabled whether to verify table files
+ */
+void setVerifyTables(bool enabled);
+
+/**
+ * Get whether table files are verified when loading, see setVerifyTables().
+ * @returns whether to verify table files
+ */
+bool getVerifyTables();
+
+/**
+ * Get information of the tables loaded so far, including those only built
+ * in memory, see buildTable().
+ * @returns information of the tables, in order of finishing loading
+ */
+vector<TableInfo> getLoadedTables();
+
+/**
+ * Record a table built in memory only, so that it's reported by
+ * getLoadedTables(), see buildTable().
+ * @param name name of the table
+ * @param bytes memory used by the table in bytes
+ * @param seconds time used to build the table in seconds
+ */
+void recordBuiltTable(const string &name, size_t bytes, double seconds);
+
+/**
+ * Load a table from the table directory, generating it when necessary.
+ * The returned memory is read-only and stays valid until the process exits.
+ * @param name name of the table, which is also the file name
+ * @param elementSize size of each element in bytes
+ * @param count number of elements
+ * @param generate function filling zero-initialized memory of
+ * `elementSize` * `count` bytes with the table
+ * @returns pointer to the table
+ */
+const void* loadRawTable(const string &name, size_t elementSize, size_t count,
+                         const function<void(void *)> &generate);
+
+/**
+ * Load a table of `T` from the table directory, generating it when
+ * necessary. See loadRawTable().
+ * @param name name of the table, which is also the file name
+ * @param count number of elements
+ * @param generate function filling an array of `count` zero-initialized
+ * elements with the table
+ * @returns pointer to the first element of the table
+ */
+template<typename T>
+const T* loadTable(const string &name, size_t count,
+                   const function<void(T *)> &generate) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "table elements need to be trivially copyable");
+  return static_cast<const T*>(loadRawTable(
+      name, sizeof(T), count,
+      [&generate](void *data) { generate(static_cast<T*>(data)); }));
+}
+
+/**
+ * Build a table which is never persisted, such as a hash table or an
+ * automaton, recording its build time and memory, see recordBuiltTable().
+ * @param name name of the table
+ * @param build function returning the table
+ * @param bytes function taking the table, returning the memory it uses in
+ * bytes
+ * @returns the table
+ */
+template<typename BUILD, typename BYTES>
+auto buildTable(const string &name, const BUILD &build, const BYTES &bytes)
+    -> decltype(build()) {
+  auto start = std::chrono::steady_clock::now();
+  auto ret = build();
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+  recordBuiltTable(name, bytes(ret), seconds.count());
+  return ret;
+}
+
+}  // namespace tables
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_TABLE_STORE_HPP_
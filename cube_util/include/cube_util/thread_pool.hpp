@@ -0,0 +1,104 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_THREAD_POOL_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_THREAD_POOL_HPP_
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cube_util {
+
+using std::atomic;
+using std::condition_variable;
+using std::exception_ptr;
+using std::function;
+using std::mutex;
+using std::thread;
+using std::vector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// A fixed-size thread pool running batches of indexed tasks.
+/// The thread calling run() takes part in the batch as worker 0, so a pool of
+/// size 1 runs everything on the calling thread.
+////////////////////////////////////////////////////////////////////////////////
+class ThreadPool {
+  /** Background workers, numbered from 1 */
+  vector<thread> threads_;
+
+  /** Guards the batch state below */
+  mutex mutex_;
+
+  /** Serializes concurrent calls to run() */
+  mutex run_mutex_;
+
+  /** Signals workers that a new batch or stopping is requested */
+  condition_variable wake_;
+
+  /** Signals run() that all background workers finished the batch */
+  condition_variable done_;
+
+  /** Task function of the current batch */
+  const function<void(uint32_t, uint16_t)> *task_ = nullptr;
+
+  /** Number of tasks in the current batch */
+  uint32_t n_tasks_ = 0;
+
+  /** Next task index to hand out */
+  atomic<uint32_t> next_task_;
+
+  /** Background workers still running the current batch */
+  uint16_t running_ = 0;
+
+  /** Batch counter, used to wake workers exactly once per batch */
+  uint64_t generation_ = 0;
+
+  /** Whether the pool is being destroyed */
+  bool stopping_ = false;
+
+  /** First exception thrown by a task of the current batch */
+  exception_ptr error_;
+
+  void workerLoop(uint16_t worker);
+
+  void work(uint16_t worker);
+
+ public:
+  /**
+   * Constructor of the class.
+   * @param nThreads number of workers including the calling thread,
+   * 0 means the number of hardware threads
+   */
+  explicit ThreadPool(uint16_t nThreads = 0);
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool& operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool();
+
+  /**
+   * Get the number of workers including the calling thread.
+   * @returns number of workers
+   */
+  uint16_t size() const;
+
+  /**
+   * Run `nTasks` tasks on the pool and wait for all of them to finish.
+   * Tasks are handed out in increasing index order. If any task throws, the
+   * first exception is rethrown after the batch finishes. Tasks must not call
+   * run() on the same pool.
+   * @param nTasks number of tasks
+   * @param task function called with the task index and the worker index,
+   * the worker index is less than size()
+   */
+  void run(uint32_t nTasks, const function<void(uint32_t, uint16_t)> &task);
+};
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_THREAD_POOL_HPP_
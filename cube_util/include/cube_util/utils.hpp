@@ -3,6 +3,8 @@
 #define CUBE_UTIL_INCLUDE_CUBE_UTIL_UTILS_HPP_
 #include <cstdint>
 
+#include <array>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -150,6 +152,18 @@ const uint16_t kNUd8EdgePerm = 40320;  // 8!
 const uint16_t kNSlicePosition = 495;  // C(12, 4)
 /** Total permutations count of E-slice edges of a 3x3x3 cube. */
 const uint16_t kNSliceEdgePerm = 24;  // 4!
+/** Positions and permutations count of a group of 4 edges. */
+const uint16_t kNEdge4 = 11880;  // C(12, 4) * 4!
+/** Positions and permutations count of 4 edges within the UD 8 edges. */
+const uint16_t kNUd8Edge4 = 1680;  // C(8, 4) * 4!
+/** Total edge flips and E-slice edges positions combinations count. */
+const uint32_t kNFlipSlice = 1013760;  // 2048 * 495
+/** Number of symmetries preserving the UD axis (the D4h group). */
+const uint16_t kNSymD4h = 16;
+/** Equivalence classes count of flip-slice combinations under D4h. */
+const uint16_t kNFlipSliceClass = 64430;
+/** Number of rotations around the URF-DBL diagonal. */
+const uint16_t kNURFRotation = 3;
 
 /** Number of edges in a 3x3x3 cube */
 const uint16_t kNEdge = 12;
@@ -164,6 +178,12 @@ const uint32_t kSolvedEp = 0;
 const uint16_t kSolvedFlip = 0;
 /** E-slice edges choose index of solved state */
 const uint16_t kSolvedSlicePosition = 494;  // C(12, 4) - 1;
+/** U edges positions and permutation index of solved state */
+const uint16_t kSolvedUEdge4 = 0;
+/** D edges positions and permutation index of solved state */
+const uint16_t kSolvedDEdge4 = 1656;  // (C(8, 4) - 1) * 4!
+/** E-slice edges positions and permutation index of solved state */
+const uint16_t kSolvedSliceEdge4 = 11856;  // (C(12, 4) - 1) * 4!
 /** UD 8 Edge permutation index of solved state */
 const uint32_t kSolvedUd8Ep = 0;
 /** E-slice edges permutation index of solved state */
@@ -176,6 +196,8 @@ const uint16_t kMaxPhase2Length = 18;
 const uint16_t kMaxLength = 30;
 /** Max solution length to check if a cube is solvable. */
 const uint16_t kMaxCheckLength = 11;
+/** Max distance of cubes in the near-solved table of the solver. */
+const uint16_t kNearSolvedDepth = 4;
 /** Different move types for phase 2 */
 const uint16_t kPhase2MoveCount = 10;
 /** Possible moves in phase 2 */
@@ -205,6 +227,11 @@ enum EdgeFlips {
   kNotFlipped, kFlipped,
 };
 
+/** Groups of 4 edges, each edge `e` belongs to group `e` / 4 */
+enum EdgeGroups {
+  kUEdges, kDEdges, kSliceEdges,
+};
+
 /** Facelet mapping for corners */
 const uint16_t kCornerFaceletMap[][3] = {
     {U9, R1, F3}, {U7, F1, L3}, {U1, L1, B3}, {U3, B1, R3},
@@ -355,14 +382,14 @@ void setNFlip(array<uint16_t, SIZE> *arr, uint16_t index, uint16_t n) {
 
 /**
  * Set pruning value into pruning table.
- * Each element of the array contains pruning values for 4 indices.
+ * Each element of the table contains pruning values for 4 indices.
  * Each pruning value needs to be less than 15.
- * @param[inout] *arr table pointer
+ * @param[inout] *arr table pointer, an array or vector of uint16_t
  * @param index pruning index
  * @param p pruning value
  */
-template<size_t SIZE>
-void setPruning(array<uint16_t, SIZE> *arr, uint32_t index, uint16_t p) {
+template<typename TABLE>
+void setPruning(TABLE *arr, uint32_t index, uint16_t p) {
   auto i = index >> 2;
   auto shift = (index & 0x3) << 2;
   auto mask = ~((uint16_t)0xf << shift);
@@ -372,19 +399,75 @@ void setPruning(array<uint16_t, SIZE> *arr, uint32_t index, uint16_t p) {
 
 /**
  * Get pruning value from pruning table.
- * Each element of the array contains pruning values for 4 indices.
+ * Each element of the table contains pruning values for 4 indices.
  * Each pruning value needs to be less than 15.
- * @param arr table reference
+ * @param arr table reference, an array or vector of uint16_t
  * @param index pruning index
  * @returns the pruning value
  */
-template<size_t SIZE>
-uint16_t getPruning(const array<uint16_t, SIZE> &arr, uint32_t index) {
+template<typename TABLE>
+uint16_t getPruning(const TABLE &arr, uint32_t index) {
   auto i = index >> 2;
   auto shift = (index & 0x3) << 2;
   return (arr[i] >> shift) & 0xf;
 }
 
+/**
+ * Hint the CPU to fetch the element of a pruning table holding a pruning
+ * value, so that a later getPruning() of it doesn't stall on a cache miss.
+ * @param arr table reference, an array or vector of uint16_t
+ * @param index pruning index
+ */
+template<typename TABLE>
+void prefetchPruning(const TABLE &arr, uint32_t index) {
+  __builtin_prefetch(&arr[index >> 2]);
+}
+
+/**
+ * Set distance modulo 3 into a distance table.
+ * Each element of the table contains values for 8 indices, 3 means the
+ * distance is unknown. As the distances of two states one move apart differ
+ * by at most 1, the exact distance of a state follows from that of a
+ * neighbour.
+ * @param[inout] *arr table pointer, an array or vector of uint16_t
+ * @param index state index
+ * @param p distance modulo 3, or 3
+ */
+template<typename TABLE>
+void setMod3Pruning(TABLE *arr, uint32_t index, uint16_t p) {
+  auto i = index >> 3;
+  auto shift = (index & 0x7) << 1;
+  auto mask = ~((uint16_t)0x3 << shift);
+  p &= 0x3;
+  (*arr)[i] = ((*arr)[i] & mask) | (p << shift);
+}
+
+/**
+ * Get distance modulo 3 from a distance table.
+ * Each element of the table contains values for 8 indices, 3 means the
+ * distance is unknown.
+ * @param arr table reference, an array or vector of uint16_t
+ * @param index state index
+ * @returns distance modulo 3, or 3
+ */
+template<typename TABLE>
+uint16_t getMod3Pruning(const TABLE &arr, uint32_t index) {
+  auto i = index >> 3;
+  auto shift = (index & 0x7) << 1;
+  return (arr[i] >> shift) & 0x3;
+}
+
+/**
+ * Get the distance of a neighbour from the distance of a state and the
+ * distance modulo 3 of the neighbour.
+ * @param distance distance of the state
+ * @param mod3 distance modulo 3 of the neighbour
+ * @returns distance of the neighbour
+ */
+inline uint16_t neighbourDistance(uint16_t distance, uint16_t mod3) {
+  return distance + (mod3 + 4 - distance % 3) % 3 - 1;
+}
+
 /**
  * Get choose value for no more than #constants::kNChooseMax elements.
  * @param n total element number
@@ -451,7 +534,8 @@ bool getNParity(uint64_t index, uint16_t n);
 
 /**
  * Get a random generator which returns a random int between
- * `start` and `end` (inclusive).
+ * `start` and `end` (inclusive). Numbers are drawn from the random engine
+ * of the thread calling the generator, see threadRandomEngine().
  * @param start lower bound of random range
  * @param end upper bound of random range
  * @returns a function<int64_t()> which returns a random int on each call
@@ -0,0 +1,33 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_INCLUDE_CUBE_UTIL_WARMUP_HPP_
+#define CUBE_UTIL_INCLUDE_CUBE_UTIL_WARMUP_HPP_
+#include <cstdint>
+
+#include <vector>
+
+#include "cube_util/table_store.hpp"
+
+namespace cube_util {
+
+using std::vector;
+
+using tables::TableInfo;
+
+/**
+ * Load all move and pruning tables of 2x2x2 and 3x3x3 cubes concurrently.
+ * Tables are otherwise loaded on first use, which delays the first solve or
+ * scramble. Calling this at startup moves that cost out of the request path.
+ * Tables already loaded are not loaded again.
+ * @param nThreads number of threads to load tables on including the calling
+ * thread, 0 means the number of hardware threads
+ * @param symmetryPruning whether to load the table used by
+ * Cube333Solver::setSymmetryPruning() as well, which takes much longer than
+ * the others
+ * @returns information of all tables loaded so far, in order of finishing
+ * loading
+ */
+vector<TableInfo> warmup(uint16_t nThreads = 0, bool symmetryPruning = false);
+
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_INCLUDE_CUBE_UTIL_WARMUP_HPP_
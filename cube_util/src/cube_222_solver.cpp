@@ -1,24 +1,76 @@
 // Copyright 2019 Yunqi Ouyang
 #include "cube_util/cube_222_solver.hpp"
 
+#include <tuple>
+
+#include "cube_util/move_automaton.hpp"
 #include "cube_util/move_sequence_nnn.hpp"
+#include "cube_util/pruning_bfs.hpp"
+#include "cube_util/table_store.hpp"
+#include "table_loaders.hpp"
 
 namespace cube_util {
 
+using std::logic_error;
+using std::make_shared;
 using std::make_unique;
-using std::fill;
+using std::make_tuple;
 using std::max;
 
 using constants::kNAxis;
 using constants::kMovePerAxis;
-using constants::kInvalidAxis;
 using cube222::kSolvedPerm;
 using cube222::kSolvedTwist;
 
-using utils::setPruning;
 using utils::getPruning;
+using utils::generatePruning;
+using utils::generateDistanceMod3;
+using utils::getMod3Pruning;
+using utils::neighbourDistance;
 using utils::reverseMove;
 
+using tables::buildTable;
+using tables::getBuildPool;
+using tables::loadTable;
+
+namespace {
+
+/** Index of the solved state */
+const uint32_t kSolvedIndex = kSolvedPerm * kNTwist + kSolvedTwist;
+
+/** Number of moves the solver uses, those of the U, R and F axes */
+const uint16_t kNSearchMove = (kNAxis >> 1) * kMovePerAxis;
+
+/** Max length of the redundant sequences the search skips */
+const uint16_t kRedundantLength = 5;
+
+/**
+ * Get index of the state reached by applying a move to a state.
+ * @param index the state index
+ * @param move the move to apply
+ * @returns the new state index
+ */
+uint32_t moveIndex(uint32_t index, uint16_t move) {
+  return CubieCube222::getPermMove(index / kNTwist, move) * kNTwist +
+         CubieCube222::getTwistMove(index % kNTwist, move);
+}
+
+/**
+ * Get the automaton accepting the move sequences without redundant sequences
+ * of up to #kRedundantLength moves.
+ * @returns the automaton
+ */
+const MoveAutomaton& getAutomaton() {
+  static const auto automaton = buildTable("222_automaton", [] {
+    return MoveAutomaton(kNSearchMove, findRedundantSequences(
+        kNSearchMove, kRedundantLength, kSolvedIndex, moveIndex,
+        [](uint32_t index) { return index; }));
+  }, [](const MoveAutomaton &a) { return a.bytes(); });
+  return automaton;
+}
+
+}  // namespace
+
 Cube222Solver::Cube222Solver(const CubieCube222 &c) {
   cc_ = c;
 }
@@ -27,6 +79,14 @@ int16_t Cube222Solver::getSolutionLength() const {
   return solution_length_;
 }
 
+const SearchStats& Cube222Solver::getSearchStats() const {
+  return stats_;
+}
+
+void Cube222Solver::setDistanceTable(bool enabled) {
+  distance_table_ = enabled;
+}
+
 unique_ptr<MoveSequence> Cube222Solver::solve(uint16_t minLength) {
   _solve(minLength);
   vector<uint16_t> moves;
@@ -36,6 +96,24 @@ unique_ptr<MoveSequence> Cube222Solver::solve(uint16_t minLength) {
   return make_unique<MoveSequenceNNN>(2, moves);
 }
 
+void Cube222Solver::solveBatch(const vector<CubieCube222> &cubes,
+                               uint16_t minLength,
+                               unique_ptr<MoveSequence> *solutions,
+                               shared_ptr<ThreadPool> pool) {
+  if (pool == nullptr) {
+    pool = make_shared<ThreadPool>();
+  }
+  auto solvers = vector<Cube222Solver>(pool->size());
+  pool->run(cubes.size(), [&](uint32_t i, uint16_t worker) {
+    auto &s = solvers[worker];
+    s.cc_ = cubes[i];
+    s._solve(minLength);
+    vector<uint16_t> moves(s.solution_.begin(),
+                           s.solution_.begin() + s.solution_length_);
+    solutions[i] = make_unique<MoveSequenceNNN>(2, moves);
+  });
+}
+
 unique_ptr<MoveSequence> Cube222Solver::generate(uint16_t minLength) {
   _solve(minLength);
   vector<uint16_t> moves;
@@ -49,15 +127,19 @@ unique_ptr<MoveSequence> Cube222Solver::generate(uint16_t minLength) {
  * Core searching function.
  * @param perm permutation index to solve
  * @param twist orientation index to solve
+ * @param distance optimal solution length, only used with the distance table
  * @param moveCount move count used to solve
- * @param lastAxis axis of last move
+ * @param state state of the automaton after the moves so far
  * @param depth current search depth
  * @param saveSolution whether to save the solution
  * @returns whether the cube is solved
  */
 bool Cube222Solver::search(
-    uint16_t perm, uint16_t twist, uint16_t moveCount,
-    uint16_t lastAxis, uint16_t depth, bool saveSolution) {
+    uint16_t perm, uint16_t twist, uint16_t distance, uint16_t moveCount,
+    uint16_t state, uint16_t depth, bool saveSolution) {
+  if (kSearchStatsEnabled) {
+    stats_.phase1Nodes[depth]++;
+  }
   if (moveCount == 0) {
     if (perm == kSolvedPerm && twist == kSolvedTwist) {
       solution_length_ = saveSolution ? depth : -1;
@@ -65,16 +147,30 @@ bool Cube222Solver::search(
     }
     return false;
   }
+  const auto &automaton = getAutomaton();
+  auto allowed = automaton.getMoves(state);
   for (auto axis = 0; axis < kNAxis >> 1; axis++) {
-    if (axis != lastAxis) {
+    if ((allowed >> (axis * kMovePerAxis) & ((1u << kMovePerAxis) - 1)) != 0) {
       for (auto power = 0; power < kMovePerAxis; power++) {
         auto move = axis * kMovePerAxis + power;
+        if ((allowed >> move & 1) == 0) {
+          continue;
+        }
         solution_[depth] = move;
         auto newPerm = CubieCube222::getPermMove(perm, move);
         auto newTwist = CubieCube222::getTwistMove(twist, move);
 
-        auto pruningValue = max(getPermPruning(newPerm),
-                                getTwistPruning(newTwist));
+        uint16_t pruningValue;
+        if (distance_table_) {
+          pruningValue = neighbourDistance(
+              distance, getDistanceMod3(newPerm * kNTwist + newTwist));
+        } else {
+          pruningValue = max(getPermPruning(newPerm),
+                             getTwistPruning(newTwist));
+        }
+        if (kSearchStatsEnabled) {
+          stats_.pruningLookups += distance_table_ ? 1 : 2;
+        }
 
         // if the new state needs more than moveCount to solve,
         // it means any new state generated by the same axis
@@ -85,8 +181,8 @@ bool Cube222Solver::search(
         } else if (pruningValue == moveCount) {
           continue;
         }
-        if (search(newPerm, newTwist, moveCount - 1, axis, depth + 1,
-                   saveSolution)) {
+        if (search(newPerm, newTwist, pruningValue, moveCount - 1,
+                   automaton.next(state, move), depth + 1, saveSolution)) {
           return true;
         }
       }
@@ -105,20 +201,59 @@ void Cube222Solver::_solve(uint16_t minLength) {
     minLength = kMaxLength;
   }
 
+  if (kSearchStatsEnabled) {
+    stats_ = SearchStats();
+  }
+  StatsTimer timer(&stats_.seconds);
+  StatsTimer searchTimer(&stats_.searchSeconds);
   const auto perm = cc_.getCPIndex();
   const auto twist = cc_.getCOIndex();
+  uint16_t distance = 0;
+  if (distance_table_) {
+    // every first move closer to solved starts the first optimal solution
+    // the search would find
+    auto index = perm * kNTwist + twist;
+    distance = getDistance(index);
+    if (minLength <= distance) {
+      for (auto i = 0; i < distance; i++) {
+        index = stepCloser(index, &solution_[i]);
+      }
+      solution_length_ = distance;
+      return;
+    }
+  }
   for (auto i = minLength; i <= kMaxLength; i++) {
-    if (search(perm, twist, i, kInvalidAxis, 0, true)) {
+    if (kSearchStatsEnabled) {
+      stats_.phase1Lengths++;
+    }
+    if (search(perm, twist, distance, i, MoveAutomaton::kStart, 0, true)) {
       break;
     }
   }
 }
 
 bool Cube222Solver::isSolvableIn(uint16_t max_length) {
+  if (kSearchStatsEnabled) {
+    stats_ = SearchStats();
+  }
+  StatsTimer timer(&stats_.seconds);
+  StatsTimer searchTimer(&stats_.searchSeconds);
   const auto perm = cc_.getCPIndex();
   const auto twist = cc_.getCOIndex();
+  if (distance_table_) {
+    // only states closer than `max_length` reach solved in that many steps
+    uint32_t index = perm * kNTwist + twist;
+    uint16_t move;
+    for (auto i = 0; i < max_length && index != kSolvedIndex; i++) {
+      index = stepCloser(index, &move);
+    }
+    return index == kSolvedIndex;
+  }
   for (auto i = 0; i <= max_length; i++) {
-    if (search(perm, twist, i, kInvalidAxis, 0, false)) {
+    if (kSearchStatsEnabled) {
+      stats_.phase1Lengths++;
+    }
+    if (search(perm, twist, 0, i, MoveAutomaton::kStart, 0, false)) {
       return true;
     }
   }
@@ -126,59 +261,81 @@ bool Cube222Solver::isSolvableIn(uint16_t max_length) {
 }
 
 uint16_t Cube222Solver::getPermPruning(uint16_t perm) {
-  static auto pruningTable = [] {
-    auto ret = array<uint16_t, ((kNPerm + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    auto count = 0;
-    for (auto depth = 0; count < kNPerm; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedPerm, depth);
-        count++;
-        continue;
-      }
-      for (auto perm = 0; perm < kNPerm; perm++) {
-        if (getPruning(ret, perm) == depth - 1) {
-          for (auto move = 0; move < kNMove; move++) {
-            auto newPerm = CubieCube222::getPermMove(perm, move);
-            if (getPruning(ret, newPerm) == 0xf) {
-              setPruning(&ret, newPerm, depth);
-              count++;
-            }
-          }
-        }
-      }
-    }
-    return ret;
-  }();
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t move) {
+      return CubieCube222::getPermMove(index, move);
+    };
+    generatePruning(ret, kNPerm, kSolvedPerm, kNMove, doMove,
+                    getBuildPool(kNPerm));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "222_perm_prun", (kNPerm + 3) >> 2, generate);
   return getPruning(pruningTable, perm);
 }
 
 uint16_t Cube222Solver::getTwistPruning(uint16_t twist) {
-  static auto pruningTable = [] {
-    auto ret = array<uint16_t, ((kNTwist + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    auto count = 0;
-    for (auto depth = 0; count < kNTwist; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedTwist, depth);
-        count++;
-        continue;
-      }
-      for (auto twist = 0; twist < kNTwist; twist++) {
-        if (getPruning(ret, twist) == depth - 1) {
-          for (auto move = 0; move < kNMove; move++) {
-            auto newTwist = CubieCube222::getTwistMove(twist, move);
-            if (getPruning(ret, newTwist) == 0xf) {
-              setPruning(&ret, newTwist, depth);
-              count++;
-            }
-          }
-        }
-      }
-    }
-    return ret;
-  }();
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t move) {
+      return CubieCube222::getTwistMove(index, move);
+    };
+    generatePruning(ret, kNTwist, kSolvedTwist, kNMove, doMove,
+                    getBuildPool(kNTwist));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "222_twist_prun", (kNTwist + 3) >> 2, generate);
   return getPruning(pruningTable, twist);
 }
 
+/**
+ * Find the first move bringing a state one move closer to solved.
+ * @param index the state index, which is not solved
+ * @param[out] move the move found
+ * @returns index of the state the move leads to
+ */
+uint32_t Cube222Solver::stepCloser(uint32_t index, uint16_t *move) {
+  auto closer = (getDistanceMod3(index) + 2) % 3;
+  for (*move = 0; *move < kNMove; (*move)++) {
+    auto newIndex = moveIndex(index, *move);
+    if (getDistanceMod3(newIndex) == closer) {
+      return newIndex;
+    }
+  }
+  throw logic_error("no move towards solved state");
+}
+
+uint16_t Cube222Solver::getDistanceMod3(uint32_t index) {
+  const uint32_t totalCount = kNPerm * kNTwist;
+  auto generate = [](uint16_t *ret) {
+    generateDistanceMod3(ret, totalCount, kSolvedIndex, kNMove, moveIndex,
+                         getBuildPool(totalCount));
+  };
+  static auto distanceTable = loadTable<uint16_t>(
+      "222_distance", (totalCount + 7) >> 3, generate);
+  return getMod3Pruning(distanceTable, index);
+}
+
+uint16_t Cube222Solver::getDistance(uint32_t index) {
+  uint16_t distance = 0;
+  uint16_t move;
+  for (; index != kSolvedIndex; distance++) {
+    index = stepCloser(index, &move);
+  }
+  return distance;
+}
+
+namespace tables {
+
+vector<function<void()>> get222TableLoaders() {
+  return {
+    [] { CubieCube222::getPermMove(0, 0); },
+    [] { CubieCube222::getTwistMove(0, 0); },
+    [] { Cube222Solver::getPermPruning(0); },
+    [] { Cube222Solver::getTwistPruning(0); },
+    [] { Cube222Solver::getDistanceMod3(0); },
+    [] { getAutomaton(); },
+  };
+}
+
+}  // namespace tables
+
 }  // namespace cube_util
@@ -1,14 +1,35 @@
 // Copyright 2019 Yunqi Ouyang
 #include "cube_util/cube_333_solver.hpp"
 
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+
+#if defined(CUBE_UTIL_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define CUBE_UTIL_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "cube_util/move_automaton.hpp"
 #include "cube_util/move_sequence_nnn.hpp"
+#include "cube_util/pruning_bfs.hpp"
+#include "cube_util/table_store.hpp"
+#include "table_loaders.hpp"
 
 namespace cube_util {
 
+using std::make_shared;
 using std::make_unique;
 using std::max;
 using std::min;
-using std::fill;
+using std::copy;
+using std::copy_n;
+using std::lock_guard;
+using std::memory_order_relaxed;
+using std::mutex;
+using std::make_tuple;
+using std::tuple;
 using std::to_string;
 using std::invalid_argument;
 using std::runtime_error;
@@ -16,29 +37,425 @@ using std::runtime_error;
 using cube333::kMaxPhase1Length;
 using cube333::kMaxPhase2Length;
 using cube333::kMaxCheckLength;
+using cube333::kNearSolvedDepth;
 using cube333::kNEdgeFlip;
 using cube333::kNCornerTwist;
 using cube333::kNSlicePosition;
 using cube333::kNCornerPerm;
 using cube333::kNSliceEdgePerm;
 using cube333::kNUd8EdgePerm;
+using cube333::kNSymD4h;
+using cube333::kNFlipSliceClass;
+using cube333::kNURFRotation;
 using cube333::kSolvedCp;
 using cube333::kSolvedFlip;
 using cube333::kSolvedSlicePosition;
 using cube333::kSolvedTwist;
 using cube333::kSolvedUd8Ep;
 using cube333::kSolvedSliceEp;
+using cube333::kSolvedUEdge4;
+using cube333::kSolvedDEdge4;
+using cube333::kSolvedSliceEdge4;
+using cube333::EdgeGroups::kUEdges;
+using cube333::EdgeGroups::kDEdges;
+using cube333::EdgeGroups::kSliceEdges;
 using cube333::kPhase2MoveCount;
 using cube333::kPhase2Move;
 
 using constants::kNAxis;
 using constants::kMovePerAxis;
-using constants::kInvalidAxis;
 
-using utils::setPruning;
 using utils::getPruning;
+using utils::getMod3Pruning;
+using utils::neighbourDistance;
+using utils::prefetchPruning;
+using utils::generatePruning;
+using utils::generateDistanceMod3;
 using utils::reverseMove;
 
+using tables::buildTable;
+using tables::getBuildPool;
+using tables::loadTable;
+
+/** Number of moves leading to each subtree searched by a parallel task */
+const uint16_t kParallelPrefixLength = 2;
+
+/** Number of phase 1 nodes improving search visits between deadline checks */
+const uint32_t kDeadlineCheckInterval = 1024;
+
+/**
+ * Number of slots of the near-solved table, a power of 2 at least twice the
+ * 46741 cubes within 4 moves
+ */
+const uint32_t kNearSolvedCapacity = 1 << 17;
+
+/**
+ * Max length of the redundant phase 1 sequences the search skips. Some of the
+ * longer ones end with a quarter turn of R, F, L or B while the sequence
+ * replacing them ends with a phase 2 move, which phase 1 may not end with.
+ */
+const uint16_t kPhase1RedundantLength = 4;
+
+/** Max length of the redundant phase 2 sequences the search skips */
+const uint16_t kPhase2RedundantLength = 5;
+
+namespace {
+
+/** A slot of the near-solved table */
+struct NearSolvedEntry {
+  /** `ep` * cube333::kNEdgeFlip + `eo` of the cube */
+  uint64_t edges;
+  /** `cp` * cube333::kNCornerTwist + `co` of the cube, UINT32_MAX if empty */
+  uint32_t corners;
+  /** Distance of the cube from the solved state */
+  uint16_t distance;
+};
+
+/**
+ * Find the slot of a cube in the near-solved table by linear probing.
+ * @param table the table
+ * @param corners corners key of the cube, see NearSolvedEntry
+ * @param edges edges key of the cube, see NearSolvedEntry
+ * @returns index of the slot holding the cube, or of the empty slot where
+ * it belongs
+ */
+uint32_t findNearSolved(const vector<NearSolvedEntry> &table, uint32_t corners,
+                        uint64_t edges) {
+  auto h = edges * 0x9e3779b97f4a7c15 ^ corners * 0xc2b2ae3d27d4eb4f;
+  auto slot = static_cast<uint32_t>(h ^ (h >> 32)) & (kNearSolvedCapacity - 1);
+  while (table[slot].corners != UINT32_MAX &&
+         (table[slot].corners != corners || table[slot].edges != edges)) {
+    slot = (slot + 1) & (kNearSolvedCapacity - 1);
+  }
+  return slot;
+}
+
+/**
+ * Get the keys of a cube in the near-solved table.
+ * @param cc the cube
+ * @param[out] corners corners key of the cube, see NearSolvedEntry
+ * @param[out] edges edges key of the cube, see NearSolvedEntry
+ */
+void nearSolvedKeys(const CubieCube333 &cc, uint32_t *corners,
+                    uint64_t *edges) {
+  *corners = static_cast<uint32_t>(cc.getCPIndex()) * kNCornerTwist +
+      cc.getCOIndex();
+  *edges = static_cast<uint64_t>(cc.getEPIndex()) * kNEdgeFlip +
+      cc.getEOIndex();
+}
+
+/**
+ * Get the table of all cubes within kNearSolvedDepth moves, generated by a
+ * breadth-first search on first use.
+ * @returns the table
+ */
+const vector<NearSolvedEntry>& getNearSolvedTable() {
+  static const auto table = buildTable("333_near_solved", [] {
+    vector<NearSolvedEntry> ret(kNearSolvedCapacity,
+                                NearSolvedEntry{0, UINT32_MAX, 0});
+    vector<CubieCube333> frontier = {CubieCube333()};
+    uint32_t corners;
+    uint64_t edges;
+    nearSolvedKeys(frontier[0], &corners, &edges);
+    ret[findNearSolved(ret, corners, edges)] = {edges, corners, 0};
+    for (auto depth = 1; depth <= kNearSolvedDepth; depth++) {
+      vector<CubieCube333> next;
+      for (const auto &cc : frontier) {
+        for (auto move = 0; move < kNMove; move++) {
+          auto c = cc;
+          c.move(move);
+          nearSolvedKeys(c, &corners, &edges);
+          auto &entry = ret[findNearSolved(ret, corners, edges)];
+          if (entry.corners == UINT32_MAX) {
+            entry = {edges, corners, static_cast<uint16_t>(depth)};
+            next.push_back(c);
+          }
+        }
+      }
+      frontier.swap(next);
+    }
+    return ret;
+  }, [](const vector<NearSolvedEntry> &ret) {
+    return ret.size() * sizeof(NearSolvedEntry);
+  });
+  return table;
+}
+
+/**
+ * Get the twist and E-slice position pruning table, see
+ * Cube333Solver::getTwistSlicePruning().
+ * @returns the table
+ */
+const uint16_t* getTwistSlicePruningTable() {
+  const uint32_t totalCount = kNCornerTwist * kNSlicePosition;
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t move) {
+      auto newTwist = CubieCube333::getTwistMove(index / kNSlicePosition, move);
+      auto newSlice =
+          CubieCube333::getSlicePositionMove(index % kNSlicePosition, move);
+      return newTwist * kNSlicePosition + newSlice;
+    };
+    generatePruning(ret, totalCount,
+                    kSolvedTwist * kNSlicePosition + kSolvedSlicePosition,
+                    kNMove, doMove, getBuildPool(totalCount));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "333_twist_slice_prun", (totalCount + 3) >> 2, generate);
+  return pruningTable;
+}
+
+/**
+ * Get the flip and E-slice position pruning table, see
+ * Cube333Solver::getFlipSlicePruning().
+ * @returns the table
+ */
+const uint16_t* getFlipSlicePruningTable() {
+  const uint32_t totalCount = kNEdgeFlip * kNSlicePosition;
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t move) {
+      auto newFlip = CubieCube333::getFlipMove(index / kNSlicePosition, move);
+      auto newSlice =
+          CubieCube333::getSlicePositionMove(index % kNSlicePosition, move);
+      return newFlip * kNSlicePosition + newSlice;
+    };
+    generatePruning(ret, totalCount,
+                    kSolvedFlip * kNSlicePosition + kSolvedSlicePosition,
+                    kNMove, doMove, getBuildPool(totalCount));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "333_flip_slice_prun", (totalCount + 3) >> 2, generate);
+  return pruningTable;
+}
+
+/**
+ * Get the corner permutation and E-slice permutation pruning table, see
+ * Cube333Solver::getCPSliceEPPruning().
+ * @returns the table
+ */
+const uint16_t* getCPSliceEPPruningTable() {
+  const uint32_t totalCount = kNCornerPerm * kNSliceEdgePerm;
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t i) {
+      auto newCP = CubieCube333::getCPMove(index / kNSliceEdgePerm, i);
+      auto newSliceEP =
+          CubieCube333::getSliceEPMove(index % kNSliceEdgePerm, i);
+      return newCP * kNSliceEdgePerm + newSliceEP;
+    };
+    generatePruning(ret, totalCount, kSolvedCp * kNSliceEdgePerm +
+                                     kSolvedSliceEp,
+                    kPhase2MoveCount, doMove, getBuildPool(totalCount));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "333_cp_slice_ep_prun", (totalCount + 3) >> 2, generate);
+  return pruningTable;
+}
+
+/**
+ * Get the UD 8 edges permutation and E-slice permutation pruning table, see
+ * Cube333Solver::getUD8EPSliceEPPruning().
+ * @returns the table
+ */
+const uint16_t* getUD8EPSliceEPPruningTable() {
+  const uint32_t totalCount = kNUd8EdgePerm * kNSliceEdgePerm;
+  auto generate = [](uint16_t *ret) {
+    auto doMove = [](uint32_t index, uint16_t i) {
+      auto newUD8EP = CubieCube333::getUD8EPMove(index / kNSliceEdgePerm, i);
+      auto newSliceEP =
+          CubieCube333::getSliceEPMove(index % kNSliceEdgePerm, i);
+      return newUD8EP * kNSliceEdgePerm + newSliceEP;
+    };
+    generatePruning(ret, totalCount, kSolvedUd8Ep * kNSliceEdgePerm +
+                                     kSolvedSliceEp,
+                    kPhase2MoveCount, doMove, getBuildPool(totalCount));
+  };
+  static auto pruningTable = loadTable<uint16_t>(
+      "333_ud8_ep_slice_ep_prun", (totalCount + 3) >> 2, generate);
+  return pruningTable;
+}
+
+/**
+ * Get the key identifying the state of a cube.
+ * @param c the cube
+ * @returns the key
+ */
+tuple<uint16_t, uint16_t, uint32_t, uint16_t> getStateKey(
+    const CubieCube333 &c) {
+  return make_tuple(c.getCPIndex(), c.getCOIndex(), c.getEPIndex(),
+                    c.getEOIndex());
+}
+
+/**
+ * Get the automaton accepting the phase 1 move sequences without redundant
+ * sequences of up to #kPhase1RedundantLength moves.
+ * @returns the automaton
+ */
+const MoveAutomaton& getPhase1Automaton() {
+  static const auto automaton = buildTable("333_phase1_automaton", [] {
+    return MoveAutomaton(kNMove, findRedundantSequences(
+        kNMove, kPhase1RedundantLength, CubieCube333(),
+        [](CubieCube333 c, uint16_t move) {
+          c.move(move);
+          return c;
+        }, getStateKey));
+  }, [](const MoveAutomaton &a) { return a.bytes(); });
+  return automaton;
+}
+
+/**
+ * Get the automaton accepting the phase 2 move sequences without redundant
+ * sequences of up to #kPhase2RedundantLength moves. Its moves are indices
+ * into cube333::kPhase2Move.
+ * @returns the automaton
+ */
+const MoveAutomaton& getPhase2Automaton() {
+  static const auto automaton = buildTable("333_phase2_automaton", [] {
+    return MoveAutomaton(kPhase2MoveCount, findRedundantSequences(
+        kPhase2MoveCount, kPhase2RedundantLength, CubieCube333(),
+        [](CubieCube333 c, uint16_t i) {
+          c.move(kPhase2Move[i]);
+          return c;
+        }, getStateKey));
+  }, [](const MoveAutomaton &a) { return a.bytes(); });
+  return automaton;
+}
+
+/**
+ * Compare the phase 1 pruning values of all 18 children of a node with the
+ * moves left, one move at a time.
+ * @param co corner orientation index of the node
+ * @param eo edge orientation index of the node
+ * @param slice E-slice edges positions index of the node
+ * @param moveCount moves left at the node
+ * @param[out] below bitmask of moves whose child has a pruning value less
+ * than `moveCount`
+ * @param[out] above bitmask of moves whose child has a pruning value greater
+ * than `moveCount`
+ */
+void comparePhase1ChildrenScalar(uint16_t co, uint16_t eo, uint16_t slice,
+                                 uint16_t moveCount, uint32_t *below,
+                                 uint32_t *above) {
+  const auto &twists = CubieCube333::getTwistMoves(co);
+  const auto &flips = CubieCube333::getFlipMoves(eo);
+  const auto &slices = CubieCube333::getSlicePositionMoves(slice);
+  auto twistSlice = getTwistSlicePruningTable();
+  auto flipSlice = getFlipSlicePruningTable();
+  // compute all indices and prefetch them before the first lookup, so that
+  // the cache misses overlap
+  array<uint32_t, kNMove> twistIndex;
+  array<uint32_t, kNMove> flipIndex;
+  for (auto move = 0; move < kNMove; move++) {
+    twistIndex[move] = twists[move] * kNSlicePosition + slices[move];
+    flipIndex[move] = flips[move] * kNSlicePosition + slices[move];
+    prefetchPruning(twistSlice, twistIndex[move]);
+    prefetchPruning(flipSlice, flipIndex[move]);
+  }
+  *below = 0;
+  *above = 0;
+  for (auto move = 0; move < kNMove; move++) {
+    auto pruningValue = max(getPruning(twistSlice, twistIndex[move]),
+                            getPruning(flipSlice, flipIndex[move]));
+    *below |= static_cast<uint32_t>(pruningValue < moveCount) << move;
+    *above |= static_cast<uint32_t>(pruningValue > moveCount) << move;
+  }
+}
+
+#ifdef CUBE_UTIL_AVX2_KERNELS
+/**
+ * Look up 8 pruning values at once, see utils::getPruning(). Each value is
+ * read from the aligned 32-bit word holding it, which never goes past the
+ * 8-byte aligned end of the table.
+ * @param table the pruning table
+ * @param index pruning indices
+ * @returns the pruning values
+ */
+__attribute__((target("avx2")))
+__m256i gatherPruning(const uint16_t *table, __m256i index) {
+  auto words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table),
+                                      _mm256_srli_epi32(index, 3), 4);
+  auto shift = _mm256_slli_epi32(
+      _mm256_and_si256(index, _mm256_set1_epi32(0x7)), 2);
+  return _mm256_and_si256(_mm256_srlv_epi32(words, shift),
+                          _mm256_set1_epi32(0xf));
+}
+
+/**
+ * Load 8 coordinates widened to 32 bits.
+ * @param coords pointer to the coordinates
+ * @returns the coordinates
+ */
+__attribute__((target("avx2")))
+__m256i loadCoords(const uint16_t *coords) {
+  return _mm256_cvtepu16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(coords)));
+}
+
+/**
+ * comparePhase1ChildrenScalar() with AVX2, 8 children at a time. The move
+ * tables hold all 18 children of a coordinate next to each other, so the
+ * coordinates of 8 children come with one load.
+ */
+__attribute__((target("avx2")))
+void comparePhase1ChildrenAvx2(uint16_t co, uint16_t eo, uint16_t slice,
+                               uint16_t moveCount, uint32_t *below,
+                               uint32_t *above) {
+  auto twists = CubieCube333::getTwistMoves(co).data();
+  auto flips = CubieCube333::getFlipMoves(eo).data();
+  auto slices = CubieCube333::getSlicePositionMoves(slice).data();
+  auto twistSlice = getTwistSlicePruningTable();
+  auto flipSlice = getFlipSlicePruningTable();
+  const auto nSlice = _mm256_set1_epi32(kNSlicePosition);
+  const auto count = _mm256_set1_epi32(moveCount);
+  *below = 0;
+  *above = 0;
+  const auto nVector = kNMove / 8 * 8;
+  for (auto move = 0; move < nVector; move += 8) {
+    auto newSlice = loadCoords(slices + move);
+    auto twistIndex =
+        _mm256_add_epi32(_mm256_mullo_epi32(loadCoords(twists + move), nSlice),
+                         newSlice);
+    auto flipIndex =
+        _mm256_add_epi32(_mm256_mullo_epi32(loadCoords(flips + move), nSlice),
+                         newSlice);
+    auto pruningValue = _mm256_max_epu32(gatherPruning(twistSlice, twistIndex),
+                                         gatherPruning(flipSlice, flipIndex));
+    *below |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_cmpgt_epi32(count, pruningValue)))) << move;
+    *above |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_cmpgt_epi32(pruningValue, count)))) << move;
+  }
+  for (auto move = nVector; move < kNMove; move++) {
+    auto pruningValue = max(
+        getPruning(twistSlice, twists[move] * kNSlicePosition + slices[move]),
+        getPruning(flipSlice, flips[move] * kNSlicePosition + slices[move]));
+    *below |= static_cast<uint32_t>(pruningValue < moveCount) << move;
+    *above |= static_cast<uint32_t>(pruningValue > moveCount) << move;
+  }
+}
+#endif
+
+/** Signature of the functions comparing phase 1 children */
+using ComparePhase1Children = void (*)(uint16_t, uint16_t, uint16_t, uint16_t,
+                                       uint32_t *, uint32_t *);
+
+/**
+ * Get the fastest function comparing phase 1 children the CPU supports.
+ * @returns the function
+ */
+ComparePhase1Children getPhase1ChildrenKernel() {
+#ifdef CUBE_UTIL_AVX2_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return comparePhase1ChildrenAvx2;
+  }
+#endif
+  return comparePhase1ChildrenScalar;
+}
+
+/** The function comparing phase 1 children, chosen once at startup */
+const ComparePhase1Children phase1ChildrenKernel = getPhase1ChildrenKernel();
+
+}  // namespace
+
 Cube333Solver::Cube333Solver(const CubieCube333 &c) {
   cc_ = c;
 }
@@ -47,6 +464,39 @@ int16_t Cube333Solver::getSolutionLength() const {
   return solution_length_;
 }
 
+const SearchStats& Cube333Solver::getSearchStats() const {
+  return stats_;
+}
+
+void Cube333Solver::setThreadPool(shared_ptr<ThreadPool> pool,
+                                  bool deterministic) {
+  pool_ = pool;
+  deterministic_ = deterministic;
+}
+
+void Cube333Solver::setSymmetryPruning(bool enabled) {
+  sym_pruning_ = enabled;
+}
+
+void Cube333Solver::setSixWaySearch(bool enabled) {
+  six_way_ = enabled;
+}
+
+/**
+ * Get lower bound of moves needed to solve phase1.
+ * @param co corner orientation index
+ * @param eo edge orientation index
+ * @param slice E-slice edges positions index
+ * @returns the pruning value
+ */
+uint16_t Cube333Solver::phase1Pruning(uint16_t co, uint16_t eo,
+                                      uint16_t slice) const {
+  if (sym_pruning_) {
+    return getFlipSliceTwistPruning(eo, slice, co);
+  }
+  return max(getTwistSlicePruning(co, slice), getFlipSlicePruning(eo, slice));
+}
+
 /**
  * Iterating search function.
  * Try each depth to search for a solution.
@@ -59,104 +509,418 @@ bool Cube333Solver::_solve(uint16_t maxLength) {
     return true;
   }
 
+  if (kSearchStatsEnabled) {
+    stats_ = SearchStats();
+  }
+  StatsTimer timer(&stats_.seconds);
+  StatsTimer searchTimer(&stats_.searchSeconds);
   phase1_length_ = -1;
   solution_length_ = -1;
+  max_length_ = maxLength;
+  if (six_way_) {
+    return sixWaySolve();
+  }
+
+  auto upperBound = min(maxLength, kMaxPhase1Length);
+  for (auto i = 0; i <= upperBound; i++) {
+    if (searchPhase1(i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Search for solutions with phase1 of given length.
+ * @param moveCount length of phase1
+ * @returns whether the cube is solved
+ */
+bool Cube333Solver::searchPhase1(uint16_t moveCount) {
+  if (kSearchStatsEnabled) {
+    stats_.phase1Lengths++;
+  }
   auto co = cc_.getCOIndex();
   auto eo = cc_.getEOIndex();
   auto slice = cc_.getSlicePositionIndex();
+  auto distance = phase1Pruning(co, eo, slice);
+  resetPhase2Path();
+  if (pool_ != nullptr && moveCount >= kParallelPrefixLength) {
+    return parallelPhase1(co, eo, slice, distance, moveCount);
+  }
+  return phase1(co, eo, slice, distance, moveCount, MoveAutomaton::kStart, 0);
+}
 
-  auto upperBound = min(maxLength, kMaxPhase1Length);
-  for (auto i = 0; i <= upperBound; i++) {
-    if (phase1(co, eo, slice, i, kInvalidAxis, 0, maxLength)) {
+/**
+ * Iterating search function searching six cubes by turns.
+ * Search `i` is on the cube rotated `i / 2` times around the URF-DBL
+ * diagonal, and inverted if `i` is odd.
+ * @returns whether the cube is solved
+ */
+bool Cube333Solver::sixWaySolve() {
+  const auto nSearch = kNURFRotation * 2;
+  auto searches = vector<Cube333Solver>(nSearch, *this);
+  for (auto i = 0; i < nSearch; i++) {
+    auto c = cc_.rotateURF(i / 2);
+    searches[i].cc_ = i % 2 == 0 ? c : c.inverse();
+    searches[i].six_way_ = false;
+  }
+
+  auto collectStats = [&] {
+    for (const auto &s : searches) {
+      stats_ += s.stats_;
+    }
+  };
+  auto upperBound = min(max_length_, kMaxPhase1Length);
+  for (auto depth = 0; depth <= upperBound; depth++) {
+    for (auto i = 0; i < nSearch; i++) {
+      auto &s = searches[i];
+      if (!s.searchPhase1(depth)) {
+        continue;
+      }
+      if (kSearchStatsEnabled) {
+        collectStats();
+      }
+      // a solution of the inverse solves the cube when reversed
+      solution_length_ = s.solution_length_;
+      phase1_length_ = s.phase1_length_;
+      for (auto j = 0; j < solution_length_; j++) {
+        auto move = i % 2 == 0 ? s.solution_[j] :
+            reverseMove(s.solution_[solution_length_ - 1 - j]);
+        solution_[j] = CubieCube333::getURFMoveConj(move, i / 2);
+      }
       return true;
     }
   }
+  if (kSearchStatsEnabled) {
+    collectStats();
+  }
   return false;
 }
 
+/**
+ * Find the children of a phase1 node worth searching, in the order of the
+ * moves leading to them.
+ * Moves on the axis of the last move are skipped, and URF moves always come
+ * before DLB moves of the same axis. A child is searched if its pruning value
+ * is less than `moveCount`. Once a child has a pruning value greater than
+ * `moveCount`, any other child generated by the same axis needs at least
+ * `moveCount` moves to solve, so the rest of the axis is skipped.
+ * Without the symmetry-reduced table, pruning values of all 18 children are
+ * compared at once, see comparePhase1Children(). With it, the distance of a
+ * child follows from `distance` and the distance modulo 3 of the child.
+ * @param co corner orientation index of the node
+ * @param eo edge orientation index of the node
+ * @param slice E-slice edges positions index of the node
+ * @param distance distance of the node in the symmetry-reduced table, only
+ * used with symmetry pruning
+ * @param moveCount moves left at the node
+ * @param state state of #getPhase1Automaton after the moves so far
+ * @param[out] distances distances of the children to search in the
+ * symmetry-reduced table indexed by move, only set with symmetry pruning
+ * @returns bitmask of the moves leading to children to search
+ */
+uint32_t Cube333Solver::phase1Children(uint16_t co, uint16_t eo,
+                                       uint16_t slice, uint16_t distance,
+                                       uint16_t moveCount, uint16_t state,
+                                       array<uint16_t, kNMove> *distances) {
+  uint32_t ret = 0;
+  auto allowed = getPhase1Automaton().getMoves(state);
+  if (sym_pruning_) {
+    for (auto axis = 0; axis < kNAxis; axis++) {
+      for (auto power = 0; power < kMovePerAxis; power++) {
+        auto move = axis * kMovePerAxis + power;
+        if ((allowed >> move & 1) == 0) {
+          continue;
+        }
+        auto pruningValue = neighbourDistance(
+            distance, getFlipSliceTwistDistanceMod3(
+                CubieCube333::getFlipMove(eo, move),
+                CubieCube333::getSlicePositionMove(slice, move),
+                CubieCube333::getTwistMove(co, move)));
+        if (kSearchStatsEnabled) {
+          stats_.pruningLookups++;
+        }
+        if (pruningValue > moveCount) {
+          break;
+        } else if (pruningValue < moveCount) {
+          ret |= 1u << move;
+          (*distances)[move] = pruningValue;
+        }
+      }
+    }
+    return ret;
+  }
+
+  uint32_t below;
+  uint32_t above;
+  phase1ChildrenKernel(co, eo, slice, moveCount, &below, &above);
+  if (kSearchStatsEnabled) {
+    stats_.pruningLookups += 2 * kNMove;
+  }
+  const uint32_t axisMask = (1u << kMovePerAxis) - 1;
+  for (auto axis = 0; axis < kNAxis; axis++) {
+    auto shift = axis * kMovePerAxis;
+    auto moves = below >> shift & axisMask;
+    auto stop = above >> shift & axisMask;
+    if (stop != 0) {
+      // keep the moves before the first one pruning the axis
+      moves &= (stop & -stop) - 1;
+    }
+    ret |= moves << shift;
+  }
+  return ret & allowed;
+}
+
+/**
+ * Collect roots of phase1 subtrees at depth #kParallelPrefixLength.
+ * It walks the tree with the same pruning as phase1 does, so the tasks are
+ * collected in the order phase1 would visit them.
+ * @param co corner orientation index to solve
+ * @param eo edge orientation index to solve
+ * @param slice E-slice edges positions index to solve
+ * @param distance distance in the symmetry-reduced table, only used with
+ * symmetry pruning
+ * @param moveCount move count used to solve
+ * @param state state of #getPhase1Automaton after the moves so far
+ * @param depth current search depth
+ * @param[out] tasks collected subtrees
+ */
+void Cube333Solver::collectPhase1Tasks(uint16_t co, uint16_t eo,
+                                       uint16_t slice, uint16_t distance,
+                                       uint16_t moveCount, uint16_t state,
+                                       uint16_t depth,
+                                       vector<Phase1Task> *tasks) {
+  if (depth == kParallelPrefixLength) {
+    Phase1Task task;
+    copy_n(solution_.begin(), kParallelPrefixLength, task.moves.begin());
+    task.co = co;
+    task.eo = eo;
+    task.slice = slice;
+    task.distance = distance;
+    task.state = state;
+    tasks->push_back(task);
+    return;
+  }
+  if (kSearchStatsEnabled) {
+    stats_.phase1Nodes[depth]++;
+  }
+  array<uint16_t, kNMove> distances;
+  auto children = phase1Children(co, eo, slice, distance, moveCount, state,
+                                 &distances);
+  for (; children != 0; children &= children - 1) {
+    uint16_t move = __builtin_ctz(children);
+    solution_[depth] = move;
+    collectPhase1Tasks(CubieCube333::getTwistMove(co, move),
+                       CubieCube333::getFlipMove(eo, move),
+                       CubieCube333::getSlicePositionMove(slice, move),
+                       sym_pruning_ ? distances[move] : 0, moveCount - 1,
+                       getPhase1Automaton().next(state, move), depth + 1,
+                       tasks);
+  }
+}
+
+/**
+ * Phase1 searching function splitting the tree across #pool_.
+ * Each subtree is searched by a copy of this solver owned by the worker.
+ * @param co corner orientation index to solve
+ * @param eo edge orientation index to solve
+ * @param slice E-slice edges positions index to solve
+ * @param distance distance in the symmetry-reduced table, only used with
+ * symmetry pruning
+ * @param moveCount move count used to solve, at least #kParallelPrefixLength
+ * @returns whether the cube is solved
+ */
+bool Cube333Solver::parallelPhase1(uint16_t co, uint16_t eo, uint16_t slice,
+                                   uint16_t distance, uint16_t moveCount) {
+  vector<Phase1Task> tasks;
+  collectPhase1Tasks(co, eo, slice, distance, moveCount, MoveAutomaton::kStart,
+                     0, &tasks);
+  const uint32_t nTasks = tasks.size();
+  if (nTasks == 0) {
+    return false;
+  }
+
+  atomic<uint32_t> cutoff(nTasks);
+  mutex resultMutex;
+  auto winner = nTasks;
+  auto workers = vector<Cube333Solver>(pool_->size(), *this);
+  for (auto &w : workers) {
+    w.pool_ = nullptr;
+    w.cutoff_ = &cutoff;
+    if (kSearchStatsEnabled) {
+      w.stats_ = SearchStats();
+    }
+  }
+
+  // the time of the run is counted by each thread for its tasks instead
+  double runSeconds = 0;
+  {
+    StatsTimer runTimer(&runSeconds);
+    pool_->run(nTasks, [&](uint32_t t, uint16_t worker) {
+      if (cutoff.load(memory_order_relaxed) <= t) {
+        return;
+      }
+      auto &s = workers[worker];
+      StatsTimer taskTimer(&s.stats_.searchSeconds);
+      const auto &task = tasks[t];
+      s.task_ = t;
+      copy(task.moves.begin(), task.moves.end(), s.solution_.begin());
+      if (!s.phase1(task.co, task.eo, task.slice, task.distance,
+                    moveCount - kParallelPrefixLength, task.state,
+                    kParallelPrefixLength)) {
+        return;
+      }
+
+      lock_guard<mutex> lock(resultMutex);
+      if (t < winner) {
+        winner = t;
+        solution_ = s.solution_;
+        solution_length_ = s.solution_length_;
+        phase1_length_ = s.phase1_length_;
+      }
+      // with a fixed tie-break, only subtrees visited before this one by the
+      // serial search may still provide the result
+      auto stop = deterministic_ ? t + 1 : 0;
+      auto current = cutoff.load();
+      while (stop < current && !cutoff.compare_exchange_weak(current, stop)) {
+      }
+    });
+  }
+  if (kSearchStatsEnabled) {
+    stats_.searchSeconds -= runSeconds;
+    for (const auto &w : workers) {
+      stats_ += w.stats_;
+    }
+  }
+  return winner < nTasks;
+}
+
+/**
+ * Check whether improving search has passed its deadline.
+ * The clock is only read once every #kDeadlineCheckInterval calls.
+ * @returns whether the search should stop
+ */
+bool Cube333Solver::expired() {
+  if (!expired_ && ++unchecked_nodes_ >= kDeadlineCheckInterval) {
+    unchecked_nodes_ = 0;
+    expired_ = steady_clock::now() >= deadline_;
+  }
+  return expired_;
+}
+
 /**
  * Phase1 searching function.
  * @param co corner orientation index to solve
  * @param eo edge orientation index to solve
  * @param slice E-slice edges positions index to solve
+ * @param distance distance in the symmetry-reduced table, only used with
+ * symmetry pruning
  * @param moveCount move count used to solve
- * @param lastAxis axis of last move
+ * @param state state of #getPhase1Automaton after the moves so far
  * @param depth current search depth
- * @param maxLength how many moves in total is acceptable (including phase2)
  * @param checkOnly whether to check the cube is solvable only
  * @returns whether the cube is solved
  */
 bool Cube333Solver::phase1(uint16_t co, uint16_t eo, uint16_t slice,
-                           uint16_t moveCount, uint16_t lastAxis,
-                           uint16_t depth, uint16_t maxLength, bool checkOnly) {
+                           uint16_t distance, uint16_t moveCount,
+                           uint16_t state, uint16_t depth, bool checkOnly) {
+  if (cutoff_ != nullptr && cutoff_->load(memory_order_relaxed) <= task_) {
+    return false;
+  }
+  // improving search may have lowered the bound below this phase1 length
+  if (depth + moveCount > max_length_ || (improving_ && expired())) {
+    return false;
+  }
+  if (kSearchStatsEnabled) {
+    stats_.phase1Nodes[depth]++;
+  }
   if (moveCount == 0) {
     if (co == kSolvedCp && eo == kSolvedFlip &&
         slice == kSolvedSlicePosition) {
       if (checkOnly) {
-        auto c = CubieCube333(cc_);
-        for (auto i = 0; i < depth; i++) {
-          c.move(solution_[i]);
-        }
-        return c == CubieCube333();
+        const auto &coords = updatePhase2Path(depth);
+        return coords.cp == kSolvedCp && coords.uEdge4 == kSolvedUEdge4 &&
+               coords.dEdge4 == kSolvedDEdge4 &&
+               coords.sliceEdge4 == kSolvedSliceEdge4;
       }
       // phase1 solved
       phase1_length_ = depth;
-      return initPhase2(lastAxis, depth, maxLength);
+      return initPhase2(depth);
     }
     return false;
   }
-  for (auto axis = 0; axis < kNAxis; axis++) {
-    // we assume URF always show before DLB respectively
-    if (axis != lastAxis && axis + 3 != lastAxis) {
-      for (auto power = 0; power < kMovePerAxis; power++) {
-        auto move = axis * kMovePerAxis + power;
-
-        auto newCO = CubieCube333::getTwistMove(co, move);
-        auto newEO = CubieCube333::getFlipMove(eo, move);
-        auto newSlice = CubieCube333::getSlicePositionMove(slice, move);
-
-        auto pruningValue = max(getTwistSlicePruning(newCO, newSlice),
-                                getFlipSlicePruning(newEO, newSlice));
-
-        // if the new state needs more than moveCount to solve,
-        // it means any new state generated by the same axis
-        // needs at least moveCount moves to solve, which is not
-        // solvable in moveCount - 1 moves, so we can skip them.
-        if (pruningValue > moveCount) {
-          break;
-        } else if (pruningValue == moveCount) {
-          continue;
-        }
-
-        solution_[depth] = move;
-        if (phase1(newCO, newEO, newSlice, moveCount - 1, axis, depth + 1,
-                   maxLength, checkOnly)) {
-          return true;
-        }
-      }
+  array<uint16_t, kNMove> distances;
+  auto children = phase1Children(co, eo, slice, distance, moveCount, state,
+                                 &distances);
+  for (; children != 0; children &= children - 1) {
+    uint16_t move = __builtin_ctz(children);
+    solution_[depth] = move;
+    if (phase1(CubieCube333::getTwistMove(co, move),
+               CubieCube333::getFlipMove(eo, move),
+               CubieCube333::getSlicePositionMove(slice, move),
+               sym_pruning_ ? distances[move] : 0, moveCount - 1,
+               getPhase1Automaton().next(state, move), depth + 1,
+               checkOnly)) {
+      return true;
     }
   }
   return false;
 }
 
+/**
+ * Start #phase2_path_ over from #cc_.
+ */
+void Cube333Solver::resetPhase2Path() {
+  phase2_path_[0] = {cc_.getCPIndex(), cc_.getEdge4Index(kUEdges),
+                     cc_.getEdge4Index(kDEdges),
+                     cc_.getEdge4Index(kSliceEdges)};
+  phase2_path_length_ = 0;
+}
+
+/**
+ * Get the coordinates after the first `depth` moves of #solution_.
+ * Entries of #phase2_path_ are kept as long as the moves they were computed
+ * with are unchanged, so consecutive phase 1 solutions sharing a prefix only
+ * need table lookups for the moves after it.
+ * @param depth number of moves
+ * @returns the coordinates
+ */
+const Cube333Solver::Phase2Coords& Cube333Solver::updatePhase2Path(
+    uint16_t depth) {
+  uint16_t valid = 0;
+  while (valid < depth && valid < phase2_path_length_ &&
+         phase2_path_moves_[valid] == solution_[valid]) {
+    valid++;
+  }
+  for (auto i = valid; i < depth; i++) {
+    auto move = solution_[i];
+    const auto &from = phase2_path_[i];
+    phase2_path_[i + 1] = {
+        CubieCube333::getFullCPMove(from.cp, move),
+        CubieCube333::getEdge4Move(from.uEdge4, move),
+        CubieCube333::getEdge4Move(from.dEdge4, move),
+        CubieCube333::getEdge4Move(from.sliceEdge4, move)};
+    phase2_path_moves_[i] = move;
+  }
+  if (valid < depth) {
+    phase2_path_length_ = depth;
+  }
+  return phase2_path_[depth];
+}
+
 /**
  * Initializing phase2.
- * @param lastAxis lastAxis of phase1, or a big number indicating last move
- * doesn't exist
  * @param depth current search depth (including phase1)
- * @param maxLength how many moves in total is acceptable (including phase1)
  * @returns whether the cube is solved
  */
-bool Cube333Solver::initPhase2(uint16_t lastAxis, uint16_t depth,
-                               uint16_t maxLength) {
-  auto c = CubieCube333(cc_);
-  for (auto i = 0; i < depth; i++) {
-    c.move(solution_[i]);
+bool Cube333Solver::initPhase2(uint16_t depth) {
+  if (kSearchStatsEnabled) {
+    stats_.phase2Entries++;
   }
-
-  auto cp = c.getCPIndex();
-  auto ud8EP = c.getUD8EPIndex();
-  auto sliceEP = c.getSliceEPIndex();
+  const auto &coords = updatePhase2Path(depth);
+  auto cp = coords.cp;
+  auto ud8EP = CubieCube333::getUD8EPFromEdge4(coords.uEdge4, coords.dEdge4);
+  auto sliceEP = coords.sliceEdge4 % kNSliceEdgePerm;
 
   // we wouldn't try any phase1 ends with phase2 moves unless
   // it's already totally solved
@@ -166,6 +930,9 @@ bool Cube333Solver::initPhase2(uint16_t lastAxis, uint16_t depth,
       if (lastMove == kPhase2Move[i]) {
         if (cp != kSolvedCp || ud8EP != kSolvedUd8Ep ||
             sliceEP != kSolvedSliceEp) {
+          if (kSearchStatsEnabled) {
+            stats_.phase2Rejections++;
+          }
           return false;
         }
         break;
@@ -173,28 +940,66 @@ bool Cube333Solver::initPhase2(uint16_t lastAxis, uint16_t depth,
     }
   }
 
-  auto upperBound = min(uint16_t(maxLength - depth), kMaxPhase2Length);
+  // the phase2 automaton starts over, so the first phase2 move only follows
+  // the axis rule against the last phase1 move
+  phase2_first_moves_ = (1u << kPhase2MoveCount) - 1;
+  if (depth > 0) {
+    auto lastAxis = solution_[depth - 1] / kMovePerAxis;
+    for (auto i = 0; i < kPhase2MoveCount; i++) {
+      auto axis = kPhase2Move[i] / kMovePerAxis;
+      // we assume URF always show before DLB respectively
+      if (axis == lastAxis || axis + 3 == lastAxis) {
+        phase2_first_moves_ &= ~(1u << i);
+      }
+    }
+  }
+
+  StatsTimer timer(&stats_.phase2Seconds);
+  auto upperBound = min(uint16_t(max_length_ - depth), kMaxPhase2Length);
   for (auto i = 0; i <= upperBound; i++) {
-    if (phase2(cp, ud8EP, sliceEP, i, lastAxis, depth)) {
-      return true;
+    if (phase2(cp, ud8EP, sliceEP, i, MoveAutomaton::kStart, depth)) {
+      return improving_ ? improve() : true;
     }
   }
   return false;
 }
 
+/**
+ * Record the solution just found by improving search and tighten the bound
+ * of the total length, so that only shorter solutions are searched further.
+ * @returns whether the solution is short enough to stop searching
+ */
+bool Cube333Solver::improve() {
+  copy_n(solution_.begin(), solution_length_, best_solution_.begin());
+  best_length_ = solution_length_;
+  if (on_improve_) {
+    vector<uint16_t> moves(solution_.begin(),
+                           solution_.begin() + solution_length_);
+    on_improve_(MoveSequenceNNN(3, moves));
+  }
+  if (best_length_ <= target_length_ || best_length_ == 0) {
+    return true;
+  }
+  max_length_ = best_length_ - 1;
+  return false;
+}
+
 /**
  * Phase2 searching function.
  * @param cp corner permutation index to solve
  * @param ud8EP UD 8 edges permutation index to solve
  * @param sliceEP E-slice edges permutation index to solve
  * @param moveCount move count used to solve
- * @param lastAxis axis of last move
+ * @param state state of #getPhase2Automaton after the phase2 moves so far
  * @param depth current search depth
  * @returns whether the cube is solved
  */
 bool Cube333Solver::phase2(
     uint16_t cp, uint16_t ud8EP, uint16_t sliceEP,
-    uint16_t moveCount, uint16_t lastAxis, uint16_t depth) {
+    uint16_t moveCount, uint16_t state, uint16_t depth) {
+  if (kSearchStatsEnabled) {
+    stats_.phase2Nodes[depth - phase1_length_]++;
+  }
   if (moveCount == 0) {
     if (cp == kSolvedCp && ud8EP == kSolvedUd8Ep && sliceEP == kSolvedSliceEp) {
       solution_length_ = depth;
@@ -202,29 +1007,47 @@ bool Cube333Solver::phase2(
     }
     return false;
   }
-  for (auto i = 0; i < kPhase2MoveCount; i++) {
+  // compute all children and prefetch their pruning values before the first
+  // lookup, so that the cache misses overlap
+  auto cpSlice = getCPSliceEPPruningTable();
+  auto ud8Slice = getUD8EPSliceEPPruningTable();
+  array<uint16_t, kPhase2MoveCount> newCP;
+  array<uint16_t, kPhase2MoveCount> newUD8EP;
+  array<uint16_t, kPhase2MoveCount> newSliceEP;
+  auto children = getPhase2Automaton().getMoves(state);
+  if (depth == phase1_length_) {
+    children &= phase2_first_moves_;
+  }
+  for (auto c = children; c != 0; c &= c - 1) {
+    auto i = __builtin_ctz(c);
+    newCP[i] = CubieCube333::getCPMove(cp, i);
+    newUD8EP[i] = CubieCube333::getUD8EPMove(ud8EP, i);
+    newSliceEP[i] = CubieCube333::getSliceEPMove(sliceEP, i);
+    prefetchPruning(cpSlice, newCP[i] * kNSliceEdgePerm + newSliceEP[i]);
+    prefetchPruning(ud8Slice, newUD8EP[i] * kNSliceEdgePerm + newSliceEP[i]);
+  }
+
+  for (; children != 0; children &= children - 1) {
+    auto i = __builtin_ctz(children);
     auto move = kPhase2Move[i];
-    auto axis = move / kMovePerAxis;
-    // we assume URF always show before DLB respectively
-    if (axis != lastAxis && axis + 3 != lastAxis) {
-      auto newCP = CubieCube333::getCPMove(cp, i);
-      auto newUD8EP = CubieCube333::getUD8EPMove(ud8EP, i);
-      auto newSliceEP = CubieCube333::getSliceEPMove(sliceEP, i);
-
-      auto pruningValue = max(getCPSliceEPPruning(newCP, newSliceEP),
-                              getUD8EPSliceEPPruning(newUD8EP, newSliceEP));
-
-      // since we are not iterating moves by axis here, we can not
-      // utilize the same trick in phase1 elegantly here,
-      // but it's still doable.
-      if (pruningValue >= moveCount) {
-        continue;
-      }
+    auto pruningValue = max(
+        getPruning(cpSlice, newCP[i] * kNSliceEdgePerm + newSliceEP[i]),
+        getPruning(ud8Slice, newUD8EP[i] * kNSliceEdgePerm + newSliceEP[i]));
+    if (kSearchStatsEnabled) {
+      stats_.pruningLookups += 2;
+    }
 
-      solution_[depth] = move;
-      if (phase2(newCP, newUD8EP, newSliceEP, moveCount - 1, axis, depth + 1)) {
-        return true;
-      }
+    // since we are not iterating moves by axis here, we can not
+    // utilize the same trick in phase1 elegantly here,
+    // but it's still doable.
+    if (pruningValue >= moveCount) {
+      continue;
+    }
+
+    solution_[depth] = move;
+    if (phase2(newCP[i], newUD8EP[i], newSliceEP[i], moveCount - 1,
+               getPhase2Automaton().next(state, i), depth + 1)) {
+      return true;
     }
   }
   return false;
@@ -241,6 +1064,74 @@ unique_ptr<MoveSequence> Cube333Solver::solve(uint16_t maxLength) {
   return make_unique<MoveSequenceNNN>(3, moves);
 }
 
+void Cube333Solver::solveBatch(const vector<CubieCube333> &cubes,
+                               uint16_t maxLength,
+                               unique_ptr<MoveSequence> *solutions,
+                               shared_ptr<ThreadPool> pool) {
+  if (pool == nullptr) {
+    pool = make_shared<ThreadPool>();
+  }
+  auto solvers = vector<Cube333Solver>(pool->size());
+  pool->run(cubes.size(), [&](uint32_t i, uint16_t worker) {
+    auto &s = solvers[worker];
+    s.cc_ = cubes[i];
+    s.solution_length_ = -1;
+    if (!s._solve(maxLength)) {
+      solutions[i] = nullptr;
+      return;
+    }
+    vector<uint16_t> moves(s.solution_.begin(),
+                           s.solution_.begin() + s.solution_length_);
+    solutions[i] = make_unique<MoveSequenceNNN>(3, moves);
+  });
+}
+
+unique_ptr<MoveSequence> Cube333Solver::solveImproving(
+    uint16_t targetLength, steady_clock::time_point deadline,
+    const function<void(const MoveSequence &)> &onImprove) {
+  phase1_length_ = -1;
+  solution_length_ = -1;
+  max_length_ = kMaxLength;
+  improving_ = true;
+  target_length_ = targetLength;
+  deadline_ = deadline;
+  expired_ = false;
+  unchecked_nodes_ = 0;
+  best_length_ = -1;
+  on_improve_ = onImprove;
+  if (kSearchStatsEnabled) {
+    stats_ = SearchStats();
+  }
+  StatsTimer timer(&stats_.seconds);
+  StatsTimer searchTimer(&stats_.searchSeconds);
+
+  auto co = cc_.getCOIndex();
+  auto eo = cc_.getEOIndex();
+  auto slice = cc_.getSlicePositionIndex();
+  auto distance = phase1Pruning(co, eo, slice);
+  resetPhase2Path();
+  // each phase1 length is searched once, shorter solutions found later only
+  // lower #max_length_ for the rest of the search
+  for (auto i = 0; i <= min(max_length_, kMaxPhase1Length) && !expired_;
+       i++) {
+    if (kSearchStatsEnabled) {
+      stats_.phase1Lengths++;
+    }
+    if (phase1(co, eo, slice, distance, i, MoveAutomaton::kStart, 0)) {
+      break;
+    }
+  }
+  improving_ = false;
+  on_improve_ = nullptr;
+
+  if (best_length_ < 0) {
+    throw runtime_error("not solved!");
+  }
+  solution_ = best_solution_;
+  solution_length_ = best_length_;
+  return solve(solution_length_);
+}
+
 unique_ptr<MoveSequence> Cube333Solver::generate(uint16_t maxLength) {
   if (!_solve(maxLength)) {
     throw runtime_error("not solved!");
@@ -260,161 +1151,170 @@ bool Cube333Solver::isSolvableIn(uint16_t maxLength) {
     return true;
   }
 
+  if (kSearchStatsEnabled) {
+    stats_ = SearchStats();
+  }
+  StatsTimer timer(&stats_.seconds);
+  StatsTimer searchTimer(&stats_.searchSeconds);
+  if (maxLength <= kNearSolvedDepth) {
+    return getNearSolvedDistance(cc_) <= maxLength;
+  }
+
   auto coIndex = cc_.getCOIndex();
   auto eoIndex = cc_.getEOIndex();
   auto slicePositionIndex = cc_.getSlicePositionIndex();
-
-  auto lowerBound = max(getTwistSlicePruning(coIndex, slicePositionIndex),
-                        getFlipSlicePruning(eoIndex, slicePositionIndex));
+  resetPhase2Path();
+  max_length_ = maxLength;
+  auto lowerBound = phase1Pruning(coIndex, eoIndex, slicePositionIndex);
   auto upperBound = maxLength;
   for (auto i = lowerBound; i <= upperBound; i++) {
-    if (phase1(coIndex, eoIndex, slicePositionIndex, i, kInvalidAxis, 0,
-               maxLength, true)) {
+    if (kSearchStatsEnabled) {
+      stats_.phase1Lengths++;
+    }
+    if (phase1(coIndex, eoIndex, slicePositionIndex, lowerBound, i,
+               MoveAutomaton::kStart, 0, true)) {
       return true;
     }
   }
   return false;
 }
 
+uint16_t Cube333Solver::getNearSolvedDistance(const CubieCube333 &cc) {
+  const auto &table = getNearSolvedTable();
+  uint32_t corners;
+  uint64_t edges;
+  nearSolvedKeys(cc, &corners, &edges);
+  const auto &entry = table[findNearSolved(table, corners, edges)];
+  return entry.corners == UINT32_MAX ? kNearSolvedDepth + 1 : entry.distance;
+}
+
 uint16_t Cube333Solver::getFlipSlicePruning(uint16_t flip, uint16_t slice) {
-  static auto pruningTable = [] {
-    const uint32_t totalCount = kNEdgeFlip * kNSlicePosition;
-    auto ret = array<uint16_t, ((totalCount + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    uint32_t count = 0;
-    for (auto depth = 0; count < totalCount; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedFlip * kNSlicePosition + kSolvedSlicePosition,
-                   depth);
-        count++;
-        continue;
-      }
-      for (auto flip = 0; flip < kNEdgeFlip; flip++) {
-        for (auto slice = 0; slice < kNSlicePosition; slice++) {
-          auto index = flip * kNSlicePosition + slice;
-          if (getPruning(ret, index) == depth - 1) {
-            for (auto move = 0; move < kNMove; move++) {
-              auto newFlip = CubieCube333::getFlipMove(flip, move);
-              auto newSlice = CubieCube333::getSlicePositionMove(slice, move);
-              auto newIndex = newFlip * kNSlicePosition + newSlice;
-              if (getPruning(ret, newIndex) == 0xf) {
-                setPruning(&ret, newIndex, depth);
-                count++;
-              }
-            }
-          }
-        }
-      }
-    }
-    return ret;
-  }();
-  return getPruning(pruningTable, flip * kNSlicePosition + slice);
+  return getPruning(getFlipSlicePruningTable(), flip * kNSlicePosition + slice);
 }
 
 uint16_t Cube333Solver::getTwistSlicePruning(uint16_t twist, uint16_t slice) {
-  static auto pruningTable = [] {
-    const uint32_t totalCount = kNCornerTwist * kNSlicePosition;
-    auto ret = array<uint16_t, ((totalCount + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    uint32_t count = 0;
-    for (auto depth = 0; count < totalCount; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedTwist * kNSlicePosition + kSolvedSlicePosition,
-                   depth);
-        count++;
-        continue;
-      }
-      for (auto twist = 0; twist < kNCornerTwist; twist++) {
-        for (auto slice = 0; slice < kNSlicePosition; slice++) {
-          auto index = twist * kNSlicePosition + slice;
-          if (getPruning(ret, index) == depth - 1) {
-            for (auto move = 0; move < kNMove; move++) {
-              auto newTwist = CubieCube333::getTwistMove(twist, move);
-              auto newSlice = CubieCube333::getSlicePositionMove(slice, move);
-              auto newIndex = newTwist * kNSlicePosition + newSlice;
-              if (getPruning(ret, newIndex) == 0xf) {
-                setPruning(&ret, newIndex, depth);
-                count++;
-              }
-            }
-          }
-        }
+  return getPruning(getTwistSlicePruningTable(),
+                    twist * kNSlicePosition + slice);
+}
+
+uint16_t Cube333Solver::getFlipSliceTwistPruning(uint16_t flip,
+                                                 uint16_t slice,
+                                                 uint16_t twist) {
+  uint16_t distance = 0;
+  for (; flip != kSolvedFlip || slice != kSolvedSlicePosition ||
+         twist != kSolvedTwist; distance++) {
+    // at least one move brings the state closer, and a neighbour with the
+    // distance modulo 3 of one move closer is exactly one move closer, as
+    // neighbours differ in distance by at most one
+    auto closer = (getFlipSliceTwistDistanceMod3(flip, slice, twist) + 2) % 3;
+    for (auto move = 0; move < kNMove; move++) {
+      auto newFlip = CubieCube333::getFlipMove(flip, move);
+      auto newSlice = CubieCube333::getSlicePositionMove(slice, move);
+      auto newTwist = CubieCube333::getTwistMove(twist, move);
+      if (getFlipSliceTwistDistanceMod3(newFlip, newSlice, newTwist) ==
+          closer) {
+        flip = newFlip;
+        slice = newSlice;
+        twist = newTwist;
+        break;
       }
     }
-    return ret;
-  }();
-  return getPruning(pruningTable, twist * kNSlicePosition + slice);
+  }
+  return distance;
 }
 
-uint16_t Cube333Solver::getCPSliceEPPruning(uint16_t cp, uint16_t sliceEP) {
-  static auto pruningTable = [] {
-    const uint32_t totalCount = kNCornerPerm * kNSliceEdgePerm;
-    auto ret = array<uint16_t, ((totalCount + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    uint32_t count = 0;
-    for (auto depth = 0; count < totalCount; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedCp * kNSliceEdgePerm + kSolvedSliceEp,
-                   depth);
-        count++;
-        continue;
-      }
-      for (auto cp = 0; cp < kNCornerPerm; cp++) {
-        for (auto sliceEP = 0; sliceEP < kNSliceEdgePerm; sliceEP++) {
-          auto index = cp * kNSliceEdgePerm + sliceEP;
-          if (getPruning(ret, index) == depth - 1) {
-            for (auto i = 0; i < kPhase2MoveCount; i++) {
-              auto newCP = CubieCube333::getCPMove(cp, i);
-              auto newSliceEP = CubieCube333::getSliceEPMove(sliceEP, i);
-              auto newIndex = newCP * kNSliceEdgePerm + newSliceEP;
-              if (getPruning(ret, newIndex) == 0xf) {
-                setPruning(&ret, newIndex, depth);
-                count++;
-              }
-            }
-          }
+uint16_t Cube333Solver::getFlipSliceTwistDistanceMod3(uint16_t flip,
+                                                      uint16_t slice,
+                                                      uint16_t twist) {
+  const uint32_t totalCount = kNFlipSliceClass * kNCornerTwist;
+  auto generate = [](uint16_t *ret) {
+    // index of the state reached by applying a move to a class
+    // representative combined with a twist
+    auto doMove = [](uint32_t index, uint16_t move) {
+      auto rep = CubieCube333::getFlipSliceRep(index / kNCornerTwist);
+      auto newFlip = CubieCube333::getFlipMove(rep / kNSlicePosition, move);
+      auto newSlice =
+          CubieCube333::getSlicePositionMove(rep % kNSlicePosition, move);
+      auto newCO = CubieCube333::getTwistMove(index % kNCornerTwist, move);
+      auto flipSlice = CubieCube333::getFlipSliceSym(newFlip, newSlice);
+      return flipSlice / kNSymD4h * kNCornerTwist +
+             CubieCube333::getTwistConj(newCO, flipSlice % kNSymD4h);
+    };
+
+    // a representative with self symmetries stands for several twists,
+    // which all share the same distance
+    auto forEachEquivalent = [](uint32_t index, const auto &f) {
+      auto c = index / kNCornerTwist;
+      auto selfSym = CubieCube333::getFlipSliceSelfSym(c);
+      for (auto s = 1; s < kNSymD4h; s++) {
+        if ((selfSym >> s & 1) != 0) {
+          f(c * kNCornerTwist +
+            CubieCube333::getTwistConj(index % kNCornerTwist, s));
         }
       }
-    }
-    return ret;
-  }();
-  return getPruning(pruningTable, cp * kNSliceEdgePerm + sliceEP);
+    };
+
+    auto solvedClass =
+        CubieCube333::getFlipSliceSym(kSolvedFlip, kSolvedSlicePosition) /
+        kNSymD4h;
+    uint32_t solved = solvedClass * kNCornerTwist + kSolvedTwist;
+    generateDistanceMod3(ret, totalCount, {solved}, kNMove, doMove,
+                         forEachEquivalent, getBuildPool(totalCount));
+  };
+  static auto distanceTable = loadTable<uint16_t>(
+      "333_flip_slice_twist_dist", (totalCount + 7) >> 3, generate);
+  auto flipSlice = CubieCube333::getFlipSliceSym(flip, slice);
+  return getMod3Pruning(distanceTable,
+                    flipSlice / kNSymD4h * kNCornerTwist +
+                    CubieCube333::getTwistConj(twist, flipSlice % kNSymD4h));
+}
+
+void Cube333Solver::comparePhase1Children(uint16_t co, uint16_t eo,
+                                          uint16_t slice, uint16_t moveCount,
+                                          uint32_t *below, uint32_t *above,
+                                          bool simd) {
+  auto kernel = simd ? phase1ChildrenKernel : comparePhase1ChildrenScalar;
+  kernel(co, eo, slice, moveCount, below, above);
+}
+
+uint16_t Cube333Solver::getCPSliceEPPruning(uint16_t cp, uint16_t sliceEP) {
+  return getPruning(getCPSliceEPPruningTable(), cp * kNSliceEdgePerm + sliceEP);
 }
 
 uint16_t Cube333Solver::getUD8EPSliceEPPruning(uint16_t ud8EP,
                                                uint16_t sliceEP) {
-  static auto pruningTable = [] {
-    const uint32_t totalCount = kNUd8EdgePerm * kNSliceEdgePerm;
-    auto ret = array<uint16_t, ((totalCount + 3) >> 2)>();
-    fill(ret.begin(), ret.end(), 0xffff);
-    uint32_t count = 0;
-    for (auto depth = 0; count < totalCount; depth++) {
-      if (depth == 0) {
-        setPruning(&ret, kSolvedUd8Ep * kNSliceEdgePerm + kSolvedSliceEp,
-                   depth);
-        count++;
-        continue;
-      }
-      for (auto ud8EP = 0; ud8EP < kNUd8EdgePerm; ud8EP++) {
-        for (auto sliceEP = 0; sliceEP < kNSliceEdgePerm; sliceEP++) {
-          auto index = ud8EP * kNSliceEdgePerm + sliceEP;
-          if (getPruning(ret, index) == depth - 1) {
-            for (auto i = 0; i < kPhase2MoveCount; i++) {
-              auto newUD8EP = CubieCube333::getUD8EPMove(ud8EP, i);
-              auto newSliceEP = CubieCube333::getSliceEPMove(sliceEP, i);
-              auto newIndex = newUD8EP * kNSliceEdgePerm + newSliceEP;
-              if (getPruning(ret, newIndex) == 0xf) {
-                setPruning(&ret, newIndex, depth);
-                count++;
-              }
-            }
-          }
-        }
-      }
-    }
-    return ret;
-  }();
-  return getPruning(pruningTable, ud8EP * kNSliceEdgePerm + sliceEP);
+  return getPruning(getUD8EPSliceEPPruningTable(),
+                    ud8EP * kNSliceEdgePerm + sliceEP);
 }
 
+namespace tables {
+
+vector<function<void()>> get333TableLoaders() {
+  return {
+    [] { CubieCube333::getFlipMove(0, 0); },
+    [] { CubieCube333::getTwistMove(0, 0); },
+    [] { CubieCube333::getSlicePositionMove(0, 0); },
+    [] { CubieCube333::getUD8EPMove(0, 0); },
+    [] { CubieCube333::getSliceEPMove(0, 0); },
+    [] { CubieCube333::getCPMove(0, 0); },
+    [] { CubieCube333::getFullCPMove(0, 0); },
+    [] { CubieCube333::getEdge4Move(0, 0); },
+    [] { CubieCube333::getUD8EPFromEdge4(0, 0); },
+    [] { CubieCube333::getURFMoveConj(0, 0); },
+    [] { Cube333Solver::getFlipSlicePruning(0, 0); },
+    [] { Cube333Solver::getTwistSlicePruning(0, 0); },
+    [] { Cube333Solver::getCPSliceEPPruning(0, 0); },
+    [] { Cube333Solver::getUD8EPSliceEPPruning(0, 0); },
+    [] { Cube333Solver::getNearSolvedDistance(CubieCube333()); },
+    [] { getPhase1Automaton(); },
+    [] { getPhase2Automaton(); },
+  };
+}
+
+void load333SymmetryTable() {
+  Cube333Solver::getFlipSliceTwistDistanceMod3(0, 0, 0);
+}
+
+}  // namespace tables
+
 }  // namespace cube_util
@@ -0,0 +1,85 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/move_automaton.hpp"
+
+#include <queue>
+#include <stdexcept>
+
+namespace cube_util {
+
+using std::invalid_argument;
+using std::queue;
+
+const uint16_t MoveAutomaton::kStart;
+const uint16_t MoveAutomaton::kDead;
+
+MoveAutomaton::MoveAutomaton(uint16_t nMoves,
+                             const vector<vector<uint16_t>> &forbidden)
+    : n_moves_(nMoves) {
+  if (nMoves > 32) {
+    throw invalid_argument("too many moves");
+  }
+  // a trie of the forbidden sequences, whose nodes are the states
+  vector<uint16_t> child(nMoves, kDead);
+  vector<bool> rejected(1, false);
+  for (const auto &s : forbidden) {
+    uint16_t node = kStart;
+    for (auto move : s) {
+      auto index = node * nMoves + move;
+      if (child[index] == kDead) {
+        // the states need to fit below #kDead
+        if (rejected.size() >= kDead) {
+          throw invalid_argument("too many states");
+        }
+        child[index] = rejected.size();
+        rejected.push_back(false);
+        child.insert(child.end(), nMoves, kDead);
+      }
+      node = child[index];
+    }
+    rejected[node] = true;
+  }
+
+  // a move leads to the longest sequence in the trie which ends the
+  // sequence so far, found in breadth first order as in Aho-Corasick
+  auto nNodes = rejected.size();
+  next_.assign(nNodes * nMoves, kDead);
+  vector<uint16_t> fail(nNodes, kStart);
+  queue<uint16_t> nodes;
+  for (auto move = 0; move < nMoves; move++) {
+    auto c = child[move];
+    next_[move] = c == kDead ? kStart : c;
+    if (c != kDead) {
+      nodes.push(c);
+    }
+  }
+  while (!nodes.empty()) {
+    auto node = nodes.front();
+    nodes.pop();
+    rejected[node] = rejected[node] || rejected[fail[node]];
+    for (auto move = 0; move < nMoves; move++) {
+      auto c = child[node * nMoves + move];
+      auto fallback = next_[fail[node] * nMoves + move];
+      if (c == kDead) {
+        next_[node * nMoves + move] = fallback;
+      } else {
+        fail[c] = fallback;
+        next_[node * nMoves + move] = c;
+        nodes.push(c);
+      }
+    }
+  }
+
+  moves_.assign(nNodes, 0);
+  for (size_t node = 0; node < nNodes; node++) {
+    for (auto move = 0; move < nMoves; move++) {
+      auto &n = next_[node * nMoves + move];
+      if (rejected[n]) {
+        n = kDead;
+      } else {
+        moves_[node] |= 1u << move;
+      }
+    }
+  }
+}
+
+}  // namespace cube_util
@@ -0,0 +1,116 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/puzzle/coord_cube_333.hpp"
+
+namespace cube_util {
+
+using cube333::kNEdge;
+using cube333::kNMove;
+using cube333::kNSliceEdgePerm;
+using cube333::kSolvedCp;
+using cube333::kSolvedDEdge4;
+using cube333::kSolvedFlip;
+using cube333::kSolvedSliceEdge4;
+using cube333::kSolvedTwist;
+using cube333::kSolvedUEdge4;
+
+using cube333::EdgeGroups::kUEdges;
+using cube333::EdgeGroups::kDEdges;
+using cube333::EdgeGroups::kSliceEdges;
+
+using utils::setNComb4;
+using utils::setNFlip;
+using utils::setNPerm;
+using utils::setNTwist;
+
+CoordCube333::CoordCube333(const CubieCube333 &cc)
+    : twist_(cc.getCOIndex()), flip_(cc.getEOIndex()), cp_(cc.getCPIndex()),
+      edge4_ {cc.getEdge4Index(kUEdges), cc.getEdge4Index(kDEdges),
+              cc.getEdge4Index(kSliceEdges)} {}
+
+void CoordCube333::move(uint16_t move) {
+  move %= kNMove;
+  twist_ = CubieCube333::getTwistMove(twist_, move);
+  flip_ = CubieCube333::getFlipMove(flip_, move);
+  cp_ = CubieCube333::getFullCPMove(cp_, move);
+  for (auto &e : edge4_) {
+    e = CubieCube333::getEdge4Move(e, move);
+  }
+}
+
+void CoordCube333::applySequence(const vector<uint16_t> &moves) {
+  for (auto m : moves) {
+    move(m);
+  }
+}
+
+void CoordCube333::applySequence(const MoveSequence &sequence) {
+  applySequence(sequence.getMoves());
+}
+
+uint16_t CoordCube333::getTwist() const {
+  return twist_;
+}
+
+uint16_t CoordCube333::getFlip() const {
+  return flip_;
+}
+
+uint16_t CoordCube333::getCP() const {
+  return cp_;
+}
+
+uint16_t CoordCube333::getEdge4(uint16_t group) const {
+  return edge4_[group];
+}
+
+uint16_t CoordCube333::getSlicePosition() const {
+  return edge4_[kSliceEdges] / kNSliceEdgePerm;
+}
+
+uint16_t CoordCube333::getSliceEP() const {
+  return edge4_[kSliceEdges] % kNSliceEdgePerm;
+}
+
+uint16_t CoordCube333::getUD8EP() const {
+  return CubieCube333::getUD8EPFromEdge4(edge4_[kUEdges], edge4_[kDEdges]);
+}
+
+bool CoordCube333::isPhase1Solved() const {
+  return twist_ == kSolvedTwist && flip_ == kSolvedFlip &&
+         getSlicePosition() == kSolvedSliceEdge4 / kNSliceEdgePerm;
+}
+
+bool CoordCube333::isSolved() const {
+  return twist_ == kSolvedTwist && flip_ == kSolvedFlip &&
+         cp_ == kSolvedCp && edge4_[kUEdges] == kSolvedUEdge4 &&
+         edge4_[kDEdges] == kSolvedDEdge4 &&
+         edge4_[kSliceEdges] == kSolvedSliceEdge4;
+}
+
+CubieCube333 CoordCube333::toCubieCube() const {
+  array<uint16_t, kNCorner> cp, co;
+  array<uint16_t, kNEdge> ep, eo, group;
+  setNPerm(&cp, cp_, kNCorner);
+  setNTwist(&co, twist_, kNCorner);
+  setNFlip(&eo, flip_, kNEdge);
+  for (uint16_t g = kUEdges; g <= kSliceEdges; g++) {
+    uint16_t mask = g << 2;
+    array<uint16_t, 4> perm;
+    setNPerm(&perm, edge4_[g] % kNSliceEdgePerm, 4);
+    setNComb4(&group, edge4_[g] / kNSliceEdgePerm, kNEdge, mask);
+    auto k = 0;
+    for (auto i = 0; i < kNEdge; i++) {
+      if ((group[i] & 0xc) == mask) {
+        ep[i] = mask | perm[k++];
+      }
+    }
+  }
+  return CubieCube333(cp, co, ep, eo);
+}
+
+bool CoordCube333::operator==(const CoordCube333 &that) const {
+  return twist_ == that.twist_ && flip_ == that.flip_ && cp_ == that.cp_ &&
+         edge4_ == that.edge4_;
+}
+
+}  // namespace cube_util
@@ -3,6 +3,8 @@
 
 #include <sstream>
 
+#include "cube_util/table_store.hpp"
+
 namespace cube_util {
 
 using std::invalid_argument;
@@ -39,7 +41,8 @@ using utils::setNPerm;
 using utils::getNPerm;
 using utils::setNTwist;
 using utils::getNTwist;
-using utils::randomizer;
+
+using tables::loadTable;
 
 CubieCube222::CubieCube222(const array<uint16_t, kNCorner> &perm,
                            const array<uint16_t, kNCorner> &twist) {
@@ -169,8 +172,11 @@ CubieCube222 CubieCube222::fromFaceletCube(const FaceletCubeNNN &fc) {
 }
 
 CubieCube222 CubieCube222::randomCube() {
-  auto r = randomizer(0, kNTwist * kNPerm - 1);
-  return CubieCube222(r());
+  return randomCube(&threadRandomEngine());
+}
+
+CubieCube222 CubieCube222::randomCube(RandomEngine *random) {
+  return CubieCube222(static_cast<uint32_t>(random->uniform(kNTwist * kNPerm)));
 }
 
 const CubieCube222& CubieCube222::getMoveCube(uint16_t move) {
@@ -199,8 +205,7 @@ const CubieCube222& CubieCube222::getMoveCube(uint16_t move) {
 }
 
 uint16_t CubieCube222::getPermMove(uint16_t perm, uint16_t move) {
-  static auto moveTable = [] {
-    auto ret = array<array<uint16_t, kNMove>, kNPerm>();
+  auto generate = [](array<uint16_t, kNMove> *ret) {
     CubieCube222 c = CubieCube222();
     CubieCube222 d = CubieCube222();
     for (auto i = 0; i < kNPerm; i++) {
@@ -210,14 +215,14 @@ uint16_t CubieCube222::getPermMove(uint16_t perm, uint16_t move) {
         ret[i][j] = d.getCPIndex();
       }
     }
-    return ret;
-  }();
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "222_perm_move", kNPerm, generate);
   return moveTable[perm][move];
 }
 
 uint16_t CubieCube222::getTwistMove(uint16_t twist, uint16_t move) {
-  static auto moveTable = [] {
-    auto ret = array<array<uint16_t, kNMove>, kNTwist>();
+  auto generate = [](array<uint16_t, kNMove> *ret) {
     CubieCube222 c = CubieCube222();
     CubieCube222 d = CubieCube222();
     for (auto i = 0; i < kNTwist; i++) {
@@ -227,8 +232,9 @@ uint16_t CubieCube222::getTwistMove(uint16_t twist, uint16_t move) {
         ret[i][j] = d.getCOIndex();
       }
     }
-    return ret;
-  }();
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "222_twist_move", kNTwist, generate);
   return moveTable[twist][move];
 }
 
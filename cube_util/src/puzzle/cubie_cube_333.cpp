@@ -1,13 +1,20 @@
 // Copyright 2019 Yunqi Ouyang
 #include "cube_util/puzzle/cubie_cube_333.hpp"
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
+
+#include "cube_util/table_store.hpp"
 
 namespace cube_util {
 
+using std::fill;
 using std::invalid_argument;
+using std::logic_error;
 using std::ostringstream;
 using std::endl;
+using std::vector;
 
 using constants::kNFace;
 using constants::kMovePerAxis;
@@ -48,6 +55,12 @@ using cube333::kPhase2MoveCount;
 using cube333::kPhase2Move;
 using cube333::kNUd8EdgePerm;
 using cube333::kNSliceEdgePerm;
+using cube333::kNFlipSlice;
+using cube333::kNSymD4h;
+using cube333::kNFlipSliceClass;
+using cube333::kNURFRotation;
+using cube333::kNEdge4;
+using cube333::kNUd8Edge4;
 
 using cube333::Edges::UF;
 using cube333::Edges::UL;
@@ -65,6 +78,9 @@ using cube333::Edges::FR;
 using cube333::EdgeFlips::kNotFlipped;
 using cube333::EdgeFlips::kFlipped;
 
+using cube333::EdgeGroups::kUEdges;
+using cube333::EdgeGroups::kSliceEdges;
+
 using utils::getNPerm;
 using utils::setNPerm;
 using utils::getNFlip;
@@ -72,7 +88,8 @@ using utils::setNFlip;
 using utils::getNParity;
 using utils::setNComb4;
 using utils::getNComb4;
-using utils::randomizer;
+
+using tables::loadTable;
 
 CubieCube333::CubieCube333()
     : ep_ {UF, UL, UB, UR, DF, DR, DB, DL, FL, BL, BR, FR},
@@ -162,6 +179,19 @@ void CubieCube333::setSlicePosition(uint16_t index) {
   setNComb4(&ep_, index, kNEdge, 0x8);
 }
 
+void CubieCube333::setEdge4(uint16_t group, uint16_t index) {
+  uint16_t mask = group << 2;
+  array<uint16_t, 4> perm;
+  setNPerm(&perm, index % kNSliceEdgePerm, 4);
+  setNComb4(&ep_, index / kNSliceEdgePerm, kNEdge, mask);
+  auto k = 0;
+  for (auto &e : ep_) {
+    if ((e & 0xc) == mask) {
+      e = mask | perm[k++];
+    }
+  }
+}
+
 void CubieCube333::move(uint16_t move) {
   move %= kNMove;
   cubeMult(*this, getMoveCube(move), this);
@@ -208,6 +238,40 @@ void CubieCube333::cubeMult(const CubieCube333 &one,
   result->eo_ = eo;
 }
 
+void CubieCube333::symMult(const CubieCube333 &one,
+                           const CubieCube333 &another,
+                           CubieCube333 *result) {
+  auto cp = array<uint16_t, kNCorner>();
+  auto co = array<uint16_t, kNCorner>();
+  auto ep = array<uint16_t, kNEdge>();
+  auto eo = array<uint16_t, kNEdge>();
+  for (auto i = 0; i < kNCorner; i++) {
+    cp[i] = one.cp_[another.cp_[i]];
+    auto oriA = one.co_[another.cp_[i]];
+    auto oriB = another.co_[i];
+    if (oriA < 3 && oriB < 3) {
+      co[i] = (oriA + oriB) % 3;
+    } else if (oriA < 3) {
+      // only another is mirrored, so is the result
+      co[i] = (oriA + oriB - 3) % 3 + 3;
+    } else if (oriB < 3) {
+      // only one is mirrored, twists of another are reversed
+      co[i] = (oriA + 3 - oriB) % 3 + 3;
+    } else {
+      // mirrored twice, back to a regular cube
+      co[i] = (oriA + 3 - oriB) % 3;
+    }
+  }
+  for (auto i = 0; i < kNEdge; i++) {
+    ep[i] = one.ep_[another.ep_[i]];
+    eo[i] = one.eo_[another.ep_[i]] ^ another.eo_[i];
+  }
+  result->cp_ = cp;
+  result->co_ = co;
+  result->ep_ = ep;
+  result->eo_ = eo;
+}
+
 FaceletCubeNNN CubieCube333::toFaceletCube() const {
   auto f = vector<uint16_t>(kNFace * kFaceletPerFace);
   for (auto i = 0; i < kNFace; i++) {
@@ -282,6 +346,18 @@ CubieCube333 CubieCube333::fromFaceletCube(const FaceletCubeNNN &fc) {
   return CubieCube333(cp, co, ep, eo);
 }
 
+uint16_t CubieCube333::getEdge4Index(uint16_t group) const {
+  uint16_t mask = group << 2;
+  array<uint16_t, 4> perm;
+  auto k = 0;
+  for (auto e : ep_) {
+    if ((e & 0xc) == mask) {
+      perm[k++] = e & 0x3;
+    }
+  }
+  return getNComb4(ep_, kNEdge, mask) * kNSliceEdgePerm + getNPerm(perm, 4);
+}
+
 bool CubieCube333::isSolvable(uint16_t cpi, uint32_t epi) {
   uint16_t parity = getNParity(cpi, kNCorner);
   parity ^= getNParity(epi, kNEdge);
@@ -289,33 +365,35 @@ bool CubieCube333::isSolvable(uint16_t cpi, uint32_t epi) {
 }
 
 CubieCube333 CubieCube333::randomCube() {
-  auto rcp = randomizer(0, kNCornerPerm - 1);
-  auto rep = randomizer(0, kNEdgePerm - 1);
+  return randomCube(&threadRandomEngine());
+}
+
+CubieCube333 CubieCube333::randomCube(RandomEngine *random) {
   uint16_t cp;
   uint32_t ep;
   do {
-    cp = rcp();
-    ep = rep();
+    cp = random->uniform(kNCornerPerm);
+    ep = random->uniform(kNEdgePerm);
   } while (!isSolvable(cp, ep));
-  auto r = randomizer(0, kNEdgeFlip * kNCornerTwist - 1);
-  auto orient = r();
+  auto orient = random->uniform(kNEdgeFlip * kNCornerTwist);
   return CubieCube333(cp, orient % kNCornerTwist,
     ep, orient / kNCornerTwist);
 }
 
 CubieCube333 CubieCube333::randomDRCube() {
-  auto rcp = randomizer(0, kNCornerPerm - 1);
-  auto rep1 = randomizer(0, kNUd8EdgePerm - 1);
-  auto rep2 = randomizer(0, kNSliceEdgePerm - 1);
+  return randomDRCube(&threadRandomEngine());
+}
+
+CubieCube333 CubieCube333::randomDRCube(RandomEngine *random) {
   array<uint16_t, 8> epArr1;
   array<uint16_t, 4> epArr2;
   array<uint16_t, kNEdge> epArr;
   uint16_t cp, ep1, ep2;
   uint32_t ep;
   do {
-    cp = rcp();
-    ep1 = rep1();
-    ep2 = rep2();
+    cp = random->uniform(kNCornerPerm);
+    ep1 = random->uniform(kNUd8EdgePerm);
+    ep2 = random->uniform(kNSliceEdgePerm);
     setNPerm(&epArr1, ep1, 8);
     setNPerm(&epArr2, ep2, 4);
     for (auto i = 0; i < kNEdge; i++) {
@@ -405,9 +483,219 @@ const CubieCube333& CubieCube333::getMoveCube(uint16_t move) {
   return moveCubeTable[move];
 }
 
-uint16_t CubieCube333::getFlipMove(uint16_t flip, uint16_t move) {
-  static auto moveTable = [] {
-    auto ret = array<array<uint16_t, kNMove>, kNEdgeFlip>();
+const CubieCube333& CubieCube333::getSymCube(uint16_t sym) {
+  static auto symCubeTable = [] {
+    auto f2 = CubieCube333(
+        {DLF, DFR, DRB, DBL, URF, UFL, ULB, UBR},
+        {kOriented},
+        {DF, DR, DB, DL, UF, UL, UB, UR, FR, BR, BL, FL},
+        {kNotFlipped});
+    auto u4 = CubieCube333(
+        {UBR, URF, UFL, ULB, DFR, DRB, DBL, DLF},
+        {kOriented},
+        {UR, UF, UL, UB, DR, DB, DL, DF, FR, FL, BL, BR},
+        {kNotFlipped, kNotFlipped, kNotFlipped, kNotFlipped,
+            kNotFlipped, kNotFlipped, kNotFlipped, kNotFlipped,
+            kFlipped, kFlipped, kFlipped, kFlipped});
+    // a mirrored cube doesn't pass the validation of the constructor
+    auto lr2 = CubieCube333();
+    lr2.cp_ = {UFL, URF, UBR, ULB, DFR, DLF, DBL, DRB};
+    lr2.co_.fill(kOriented + 3);
+    lr2.ep_ = {UF, UR, UB, UL, DF, DL, DB, DR, FR, BR, BL, FL};
+
+    auto ret = array<CubieCube333, kNSymD4h>();
+    auto c = CubieCube333();
+    auto d = CubieCube333();
+    for (auto i = 0; i < kNSymD4h; i++) {
+      ret[i] = c;
+      symMult(c, lr2, &d);
+      c = d;
+      if (i % 2 == 1) {
+        symMult(c, u4, &d);
+        c = d;
+      }
+      if (i % 8 == 7) {
+        symMult(c, f2, &d);
+        c = d;
+      }
+    }
+    return ret;
+  }();
+  return symCubeTable[sym];
+}
+
+uint16_t CubieCube333::getSymInverse(uint16_t sym) {
+  static auto inverseTable = [] {
+    auto ret = array<uint16_t, kNSymD4h>();
+    const auto id = CubieCube333();
+    auto c = CubieCube333();
+    for (auto i = 0; i < kNSymD4h; i++) {
+      for (auto j = 0; j < kNSymD4h; j++) {
+        symMult(getSymCube(i), getSymCube(j), &c);
+        if (c.cp_ == id.cp_ && c.co_ == id.co_ &&
+            c.ep_ == id.ep_ && c.eo_ == id.eo_) {
+          ret[i] = j;
+          break;
+        }
+      }
+    }
+    return ret;
+  }();
+  return inverseTable[sym];
+}
+
+uint32_t CubieCube333::getFlipSliceConj(uint32_t flipSlice, uint16_t sym) {
+  auto c = CubieCube333();
+  auto d = CubieCube333();
+  c.setEO(flipSlice / kNSlicePosition);
+  c.setSlicePosition(flipSlice % kNSlicePosition);
+  symMult(getSymCube(getSymInverse(sym)), c, &d);
+  symMult(d, getSymCube(sym), &c);
+  return c.getEOIndex() * kNSlicePosition + c.getSlicePositionIndex();
+}
+
+uint16_t CubieCube333::getTwistConj(uint16_t twist, uint16_t sym) {
+  auto generate = [](array<uint16_t, kNSymD4h> *ret) {
+    auto c = CubieCube333();
+    auto d = CubieCube333();
+    for (auto i = 0; i < kNCornerTwist; i++) {
+      c.setCO(i);
+      for (auto s = 0; s < kNSymD4h; s++) {
+        symMult(getSymCube(s), c, &d);
+        symMult(d, getSymCube(getSymInverse(s)), &d);
+        ret[i][s] = d.getCOIndex();
+      }
+    }
+  };
+  static auto conjTable = loadTable<array<uint16_t, kNSymD4h>>(
+      "333_twist_conj", kNCornerTwist, generate);
+  return conjTable[twist][sym];
+}
+
+uint32_t CubieCube333::getFlipSliceSym(uint16_t flip, uint16_t slice) {
+  auto generate = [](uint32_t *ret) {
+    const uint32_t invalid = 0xffffffff;
+    fill(ret, ret + kNFlipSlice, invalid);
+    uint32_t classIndex = 0;
+    for (uint32_t i = 0; i < kNFlipSlice; i++) {
+      if (ret[i] != invalid) {
+        continue;
+      }
+      // the first combination of each class becomes its representative
+      for (auto s = 0; s < kNSymD4h; s++) {
+        auto index = getFlipSliceConj(i, s);
+        if (ret[index] == invalid) {
+          ret[index] = classIndex * kNSymD4h + s;
+        }
+      }
+      classIndex++;
+    }
+  };
+  static auto symTable = loadTable<uint32_t>(
+      "333_flip_slice_sym", kNFlipSlice, generate);
+  return symTable[flip * kNSlicePosition + slice];
+}
+
+uint32_t CubieCube333::getFlipSliceRep(uint16_t flipSliceClass) {
+  auto generate = [](uint32_t *ret) {
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < kNFlipSlice; i++) {
+      auto c = getFlipSliceSym(i / kNSlicePosition, i % kNSlicePosition) /
+               kNSymD4h;
+      // classes are numbered in order of their representatives
+      if (c == next) {
+        ret[next++] = i;
+      }
+    }
+  };
+  static auto repTable = loadTable<uint32_t>(
+      "333_flip_slice_rep", kNFlipSliceClass, generate);
+  return repTable[flipSliceClass];
+}
+
+uint16_t CubieCube333::getFlipSliceSelfSym(uint16_t flipSliceClass) {
+  auto generate = [](uint16_t *ret) {
+    for (auto i = 0; i < kNFlipSliceClass; i++) {
+      auto rep = getFlipSliceRep(i);
+      for (auto s = 0; s < kNSymD4h; s++) {
+        if (getFlipSliceConj(rep, s) == rep) {
+          ret[i] |= 1 << s;
+        }
+      }
+    }
+  };
+  static auto selfSymTable = loadTable<uint16_t>(
+      "333_flip_slice_self_sym", kNFlipSliceClass, generate);
+  return selfSymTable[flipSliceClass];
+}
+
+const CubieCube333& CubieCube333::getURFCube(uint16_t times) {
+  static auto urfCubeTable = [] {
+    auto urf3 = CubieCube333(
+        {URF, DFR, DLF, UFL, DRB, UBR, ULB, DBL},
+        {kClockwise, kCounterClockwise, kClockwise, kCounterClockwise,
+            kClockwise, kCounterClockwise, kClockwise, kCounterClockwise},
+        {FR, DF, FL, UF, BR, UB, BL, DB, DR, DL, UL, UR},
+        {kNotFlipped, kFlipped, kNotFlipped, kFlipped,
+            kNotFlipped, kFlipped, kNotFlipped, kFlipped,
+            kFlipped, kFlipped, kFlipped, kFlipped});
+    auto ret = array<CubieCube333, kNURFRotation>();
+    for (auto i = 1; i < kNURFRotation; i++) {
+      cubeMult(ret[i - 1], urf3, &ret[i]);
+    }
+    return ret;
+  }();
+  return urfCubeTable[times];
+}
+
+CubieCube333 CubieCube333::inverse() const {
+  auto ret = CubieCube333();
+  for (auto i = 0; i < kNCorner; i++) {
+    ret.cp_[cp_[i]] = i;
+    ret.co_[cp_[i]] = (3 - co_[i]) % 3;
+  }
+  for (auto i = 0; i < kNEdge; i++) {
+    ret.ep_[ep_[i]] = i;
+    ret.eo_[ep_[i]] = eo_[i];
+  }
+  return ret;
+}
+
+CubieCube333 CubieCube333::rotateURF(uint16_t times) const {
+  auto c = CubieCube333();
+  auto d = CubieCube333();
+  cubeMult(getURFCube((kNURFRotation - times) % kNURFRotation), *this, &c);
+  cubeMult(c, getURFCube(times), &d);
+  return d;
+}
+
+uint16_t CubieCube333::getURFMoveConj(uint16_t move, uint16_t times) {
+  static auto conjTable = [] {
+    auto ret = array<array<uint16_t, kNMove>, kNURFRotation>();
+    auto c = CubieCube333();
+    auto d = CubieCube333();
+    for (auto i = 0; i < kNURFRotation; i++) {
+      auto inv = (kNURFRotation - i) % kNURFRotation;
+      for (auto j = 0; j < kNMove; j++) {
+        cubeMult(getURFCube(i), getMoveCube(j), &c);
+        cubeMult(c, getURFCube(inv), &d);
+        auto k = 0;
+        while (k < kNMove && !(getMoveCube(k) == d)) {
+          k++;
+        }
+        if (k == kNMove) {
+          throw logic_error("rotation doesn't map moves to moves!");
+        }
+        ret[i][j] = k;
+      }
+    }
+    return ret;
+  }();
+  return conjTable[times][move];
+}
+
+const array<uint16_t, kNMove>& CubieCube333::getFlipMoves(uint16_t flip) {
+  auto generate = [](array<uint16_t, kNMove> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNEdgeFlip; i++) {
@@ -417,14 +705,18 @@ uint16_t CubieCube333::getFlipMove(uint16_t flip, uint16_t move) {
         ret[i][j] = d.getEOIndex();
       }
     }
-    return ret;
-  }();
-  return moveTable[flip][move];
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "333_flip_move", kNEdgeFlip, generate);
+  return moveTable[flip];
 }
 
-uint16_t CubieCube333::getTwistMove(uint16_t twist, uint16_t move) {
-  static auto moveTable = [] {
-    auto ret = array<array<uint16_t, kNMove>, kNCornerTwist>();
+uint16_t CubieCube333::getFlipMove(uint16_t flip, uint16_t move) {
+  return getFlipMoves(flip)[move];
+}
+
+const array<uint16_t, kNMove>& CubieCube333::getTwistMoves(uint16_t twist) {
+  auto generate = [](array<uint16_t, kNMove> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNCornerTwist; i++) {
@@ -434,15 +726,19 @@ uint16_t CubieCube333::getTwistMove(uint16_t twist, uint16_t move) {
         ret[i][j] = d.getCOIndex();
       }
     }
-    return ret;
-  }();
-  return moveTable[twist][move];
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "333_twist_move", kNCornerTwist, generate);
+  return moveTable[twist];
 }
 
-uint16_t CubieCube333::getSlicePositionMove(uint16_t slicePositionIndex,
-  uint16_t move) {
-  static auto moveTable = [] {
-    auto ret = array<array<uint16_t, kNMove>, kNSlicePosition>();
+uint16_t CubieCube333::getTwistMove(uint16_t twist, uint16_t move) {
+  return getTwistMoves(twist)[move];
+}
+
+const array<uint16_t, kNMove>& CubieCube333::getSlicePositionMoves(
+    uint16_t slicePositionIndex) {
+  auto generate = [](array<uint16_t, kNMove> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNSlicePosition; i++) {
@@ -452,15 +748,19 @@ uint16_t CubieCube333::getSlicePositionMove(uint16_t slicePositionIndex,
         ret[i][j] = d.getSlicePositionIndex();
       }
     }
-    return ret;
-  }();
-  return moveTable[slicePositionIndex][move];
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "333_slice_position_move", kNSlicePosition, generate);
+  return moveTable[slicePositionIndex];
+}
+
+uint16_t CubieCube333::getSlicePositionMove(uint16_t slicePositionIndex,
+  uint16_t move) {
+  return getSlicePositionMoves(slicePositionIndex)[move];
 }
 
 uint16_t CubieCube333::getUD8EPMove(uint16_t ud8EP, uint16_t index) {
-  static auto moveTable = [] {
-    auto ret =
-      array<array<uint16_t, kPhase2MoveCount>, kNUd8EdgePerm>();
+  auto generate = [](array<uint16_t, kPhase2MoveCount> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNUd8EdgePerm; i++) {
@@ -470,14 +770,14 @@ uint16_t CubieCube333::getUD8EPMove(uint16_t ud8EP, uint16_t index) {
         ret[i][j] = d.getUD8EPIndex();
       }
     }
-    return ret;
-  }();
+  };
+  static auto moveTable = loadTable<array<uint16_t, kPhase2MoveCount>>(
+      "333_ud8_ep_move", kNUd8EdgePerm, generate);
   return moveTable[ud8EP][index];
 }
 
 uint16_t CubieCube333::getSliceEPMove(uint16_t sliceEP, uint16_t index) {
-  static auto moveTable = [] {
-    array<array<uint16_t, kPhase2MoveCount>, kNSliceEdgePerm> ret;
+  auto generate = [](array<uint16_t, kPhase2MoveCount> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNSliceEdgePerm; i++) {
@@ -487,15 +787,14 @@ uint16_t CubieCube333::getSliceEPMove(uint16_t sliceEP, uint16_t index) {
         ret[i][j] = d.getSliceEPIndex();
       }
     }
-    return ret;
-  }();
+  };
+  static auto moveTable = loadTable<array<uint16_t, kPhase2MoveCount>>(
+      "333_slice_ep_move", kNSliceEdgePerm, generate);
   return moveTable[sliceEP][index];
 }
 
 uint16_t CubieCube333::getCPMove(uint16_t cp, uint16_t index) {
-  static auto moveTable = [] {
-    auto ret =
-      array<array<uint16_t, kPhase2MoveCount>, kNCornerPerm>();
+  auto generate = [](array<uint16_t, kPhase2MoveCount> *ret) {
     CubieCube333 c = CubieCube333();
     CubieCube333 d = CubieCube333();
     for (auto i = 0; i < kNCornerPerm; i++) {
@@ -505,11 +804,70 @@ uint16_t CubieCube333::getCPMove(uint16_t cp, uint16_t index) {
         ret[i][j] = d.getCPIndex();
       }
     }
-    return ret;
-  }();
+  };
+  static auto moveTable = loadTable<array<uint16_t, kPhase2MoveCount>>(
+      "333_cp_move", kNCornerPerm, generate);
   return moveTable[cp][index];
 }
 
+uint16_t CubieCube333::getFullCPMove(uint16_t cp, uint16_t move) {
+  auto generate = [](array<uint16_t, kNMove> *ret) {
+    CubieCube333 c = CubieCube333();
+    CubieCube333 d = CubieCube333();
+    for (auto i = 0; i < kNCornerPerm; i++) {
+      c.setCP(i);
+      for (auto j = 0; j < kNMove; j++) {
+        cubeMult(c, getMoveCube(j), &d);
+        ret[i][j] = d.getCPIndex();
+      }
+    }
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "333_full_cp_move", kNCornerPerm, generate);
+  return moveTable[cp][move];
+}
+
+uint16_t CubieCube333::getEdge4Move(uint16_t edge4, uint16_t move) {
+  auto generate = [](array<uint16_t, kNMove> *ret) {
+    CubieCube333 c = CubieCube333();
+    CubieCube333 d = CubieCube333();
+    for (auto i = 0; i < kNEdge4; i++) {
+      c.setEdge4(kSliceEdges, i);
+      for (auto j = 0; j < kNMove; j++) {
+        cubeMult(c, getMoveCube(j), &d);
+        ret[i][j] = d.getEdge4Index(kSliceEdges);
+      }
+    }
+  };
+  static auto moveTable = loadTable<array<uint16_t, kNMove>>(
+      "333_edge4_move", kNEdge4, generate);
+  return moveTable[edge4][move];
+}
+
+uint16_t CubieCube333::getUD8EPFromEdge4(uint16_t uEdge4, uint16_t dEdge4) {
+  auto generate = [](array<uint16_t, kNSliceEdgePerm> *ret) {
+    array<uint16_t, 8> ep;
+    array<uint16_t, 4> uPerm;
+    array<uint16_t, 4> dPerm;
+    for (auto i = 0; i < kNUd8Edge4; i++) {
+      setNPerm(&uPerm, i % kNSliceEdgePerm, 4);
+      for (auto j = 0; j < kNSliceEdgePerm; j++) {
+        setNPerm(&dPerm, j, 4);
+        // D edges take the positions left by the U edges, in order
+        setNComb4(&ep, i / kNSliceEdgePerm, 8, kUEdges);
+        auto u = 0, d = 0;
+        for (auto &e : ep) {
+          e = (e & 0xc) == kUEdges ? uPerm[u++] : 4 | dPerm[d++];
+        }
+        ret[i][j] = getNPerm(ep, 8);
+      }
+    }
+  };
+  static auto table = loadTable<array<uint16_t, kNSliceEdgePerm>>(
+      "333_ud8_ep_edge4", kNUd8Edge4, generate);
+  return table[uEdge4][dEdge4 % kNSliceEdgePerm];
+}
+
 bool CubieCube333::operator==(const CubieCube333 &that) const {
   return getCPIndex() == that.getCPIndex() &&
          getCOIndex() == that.getCOIndex() &&
@@ -1,18 +1,33 @@
 // Copyright 2019 Yunqi Ouyang
 #include "cube_util/puzzle/facelet_cube_nnn.hpp"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
+#if defined(CUBE_UTIL_SIMD) && defined(__SSE2__)
+#define CUBE_UTIL_SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+#include "cube_util/random.hpp"
 #include "cube_util/utils.hpp"
 
 namespace cube_util {
 
+using std::array;
+using std::call_once;
 using std::endl;
 using std::invalid_argument;
+using std::make_unique;
+using std::once_flag;
 using std::ostream;
 using std::ostringstream;
 using std::to_string;
+using std::unique_ptr;
 
 using constants::kFaceNames;
 using constants::kMaxSize;
@@ -30,13 +45,432 @@ using enums::Colors::D;
 using enums::Colors::L;
 using enums::Colors::B;
 
+namespace {
+
+/** Seed of the Zobrist keys, so that hashes do not change between runs */
+const uint64_t kKeySeed = 0x6375626575746c;
+
+/** The facelets a move changes, and where it takes each of them from */
+struct FaceletPermutation {
+  /** Indices of the facelets changed by the move */
+  vector<uint16_t> targets;
+  /** Index of the facelet moved to each of #targets */
+  vector<uint16_t> sources;
+};
+
+/** The moves of a cube size, each computed on its first use */
+struct SizeMoves {
+  once_flag allocated;
+  unique_ptr<once_flag[]> computed;
+  vector<FaceletPermutation> moves;
+  /**
+   * Layer of each facelet along the U, R and F axes in turn, counting from 0
+   * at the U, R or F face
+   */
+  vector<uint8_t> layers;
+  /**
+   * Zobrist key of each facelet in each colour, at facelet * #kNFace +
+   * colour
+   */
+  vector<uint64_t> keys;
+};
+
+/** Range of the layers along an axis of some facelets */
+struct LayerRange {
+  /** The smallest layer, or #kNoLayer if there are no facelets */
+  int lo = kNoLayer;
+  /** The largest layer, or -1 if there are no facelets */
+  int hi = -1;
+
+  static const int kNoLayer = 0xff;
+
+  bool empty() const {
+    return hi < lo;
+  }
+
+  void add(int layer) {
+    lo = std::min(lo, layer);
+    hi = std::max(hi, layer);
+  }
+
+  void add(const LayerRange &that) {
+    lo = std::min(lo, that.lo);
+    hi = std::max(hi, that.hi);
+  }
+};
+
+/**
+ * Throw if the amount of a U, R or F turn is not positive, as the layer turns
+ * of these faces do.
+ * @param amount how many times to turn
+ */
+void checkAmount(int amount) {
+  if (amount < 1) {
+    throw invalid_argument("Amount must be positive");
+  }
+}
+
+/**
+ * Turn a layer from U axis clockwise, see FaceletCubeNNN::moveu().
+ * @param size size of the cube
+ * @param layer which layer to turn, counting from 1
+ * @param amount how many times to turn, from 0 to 3
+ * @param cycle function taking 4 facelet indices, cycling the facelets
+ * from the first to the last then back to the first
+ */
+template<typename CYCLE>
+void turnULayer(int size, int layer, int amount, const CYCLE &cycle) {
+  for (auto c = 0; c < amount; c++) {
+    if (layer == 1) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              U * size * size + (i * size) + j,
+              U * size * size + (j * size) + (size - i - 1),
+              U * size * size + ((size - i - 1) * size) + (size - j - 1),
+              U * size * size + ((size - j - 1) * size) + i);
+        }
+      }
+    }
+    for (int i = 0; i < size; i++) {
+      cycle(F * size * size + (layer - 1) * size + i,
+            L * size * size + (layer - 1) * size + i,
+            B * size * size + (layer - 1) * size + i,
+            R * size * size + (layer - 1) * size + i);
+    }
+
+    if (layer == size) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              D * size * size + (i * size) + j,
+              D * size * size + ((size - j - 1) * size) + i,
+              D * size * size + ((size - i - 1) * size) + (size - j - 1),
+              D * size * size + (j * size) + (size - i - 1));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Turn a layer from R axis clockwise, see FaceletCubeNNN::mover().
+ * @param size size of the cube
+ * @param layer which layer to turn, counting from 1
+ * @param amount how many times to turn, from 0 to 3
+ * @param cycle function taking 4 facelet indices, cycling the facelets
+ * from the first to the last then back to the first
+ */
+template<typename CYCLE>
+void turnRLayer(int size, int layer, int amount, const CYCLE &cycle) {
+  for (auto c = 0; c < amount; c++) {
+    if (layer == 1) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              R * size * size + (i * size) + j,
+              R * size * size + (j * size) + (size - i - 1),
+              R * size * size + ((size - i - 1) * size) + (size - j - 1),
+              R * size * size + ((size - j - 1) * size) + i);
+        }
+      }
+    }
+    for (int i = 0; i < size; i++) {
+      cycle(U * size * size + i * size + (size - layer),
+            B * size * size + (size - i - 1) * size + (layer - 1),
+            D * size * size + i * size + (size - layer),
+            F * size * size + i * size + (size - layer));
+    }
+
+    if (layer == size) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              L * size * size + (i * size) + j,
+              L * size * size + ((size - j - 1) * size) + i,
+              L * size * size + ((size - i - 1) * size) + (size - j - 1),
+              L * size * size + (j * size) + (size - i - 1));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Turn a layer from F axis clockwise, see FaceletCubeNNN::movef().
+ * @param size size of the cube
+ * @param layer which layer to turn, counting from 1
+ * @param amount how many times to turn, from 0 to 3
+ * @param cycle function taking 4 facelet indices, cycling the facelets
+ * from the first to the last then back to the first
+ */
+template<typename CYCLE>
+void turnFLayer(int size, int layer, int amount, const CYCLE &cycle) {
+  for (auto c = 0; c < amount; c++) {
+    if (layer == 1) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              F * size * size + (i * size) + j,
+              F * size * size + (j * size) + (size - i - 1),
+              F * size * size + ((size - i - 1) * size) + (size - j - 1),
+              F * size * size + ((size - j - 1) * size) + i);
+        }
+      }
+    }
+    for (int i = 0; i < size; i++) {
+      cycle(U * size * size + (size - layer) * size + i,
+            R * size * size + i * size + (layer - 1),
+            D * size * size + (layer - 1) * size + (size - i - 1),
+            L * size * size + (size - i - 1) * size + (size - layer));
+    }
+
+    if (layer == size) {
+      for (int i = 0; i < size / 2; i ++) {
+        for (int j = i; j < size - i - 1; j++) {
+          cycle(
+              B * size * size + (i * size) + j,
+              B * size * size + ((size - j - 1) * size) + i,
+              B * size * size + ((size - i - 1) * size) + (size - j - 1),
+              B * size * size + (j * size) + (size - i - 1));
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Turn a layer clockwise.
+ * @param size size of the cube
+ * @param face the face whose axis to turn
+ * @param layer which layer to turn, counting from 1 from the face
+ * @param amount how many times to turn, from 0 to 3
+ * @param cycle function cycling 4 facelets, see turnULayer()
+ */
+template<typename CYCLE>
+void turnLayer(int size, uint16_t face, int layer, int amount,
+               const CYCLE &cycle) {
+  switch (face) {
+    case U:
+      turnULayer(size, layer, amount, cycle);
+      break;
+    case R:
+      turnRLayer(size, layer, amount, cycle);
+      break;
+    case F:
+      turnFLayer(size, layer, amount, cycle);
+      break;
+    case D:
+      turnULayer(size, size - layer + 1, (4 - amount) & 3, cycle);
+      break;
+    case L:
+      turnRLayer(size, size - layer + 1, (4 - amount) & 3, cycle);
+      break;
+    case B:
+      turnFLayer(size, size - layer + 1, (4 - amount) & 3, cycle);
+      break;
+  }
+}
+
+/**
+ * Turn a layer clockwise, see turnLayer() above.
+ * @param[inout] facelets the facelets to turn
+ * @param size size of the cube
+ * @param face the face whose axis to turn
+ * @param layer which layer to turn, counting from 1 from the face
+ * @param amount how many times to turn, from 0 to 3
+ */
+template<typename T>
+void turnLayer(vector<T> *facelets, int size, uint16_t face, int layer,
+               int amount) {
+  turnLayer(size, face, layer, amount, [facelets](int a, int b, int c, int d) {
+    cycle4(facelets, a, b, c, d);
+  });
+}
+
+/**
+ * Get the moves of a cube size, with the facelet layers and keys computed.
+ * @param size size of the cube
+ * @returns the moves
+ */
+SizeMoves& getSizeMoves(uint16_t size) {
+  static array<SizeMoves, kMaxSize + 1> sizes;
+  auto &ret = sizes[size];
+  call_once(ret.allocated, [&ret, size] {
+    const auto nMoves = kNFace * size * kMovePerAxis;
+    ret.computed = make_unique<once_flag[]>(nMoves);
+    ret.moves.resize(nMoves);
+
+    // a layer turn moves the facelets of the layer on the side faces, and
+    // the outer layers have the faces besides
+    const auto faceSize = size * size;
+    const auto nFacelets = kNFace * faceSize;
+    ret.layers.resize(kNAxis / 2 * nFacelets);
+    for (uint16_t axis = 0; axis < kNAxis / 2; axis++) {
+      auto layers = &ret.layers[axis * nFacelets];
+      for (auto l = 0; l < size; l++) {
+        vector<uint16_t> indices(nFacelets);
+        for (size_t i = 0; i < indices.size(); i++) {
+          indices[i] = i;
+        }
+        turnLayer(&indices, size, axis, l + 1, 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+          if (indices[i] != i) {
+            layers[i] = l;
+          }
+        }
+      }
+      std::fill_n(layers + axis * faceSize, faceSize, 0);
+      std::fill_n(layers + (axis + kNAxis / 2) * faceSize, faceSize,
+                  size - 1);
+    }
+
+    Xoshiro256 engine(deriveSeed(kKeySeed, size));
+    ret.keys.resize(nFacelets * kNFace);
+    for (auto &key : ret.keys) {
+      key = engine.next();
+    }
+  });
+  return ret;
+}
+
+/**
+ * Get the facelet permutation of turning the outer layers of a face, leaving
+ * out the facelets of the faces turned as a whole, see rotateFace().
+ * It is computed once per size and move, by turning the layers one by one
+ * on a cube whose facelets are their own indices.
+ * @param size size of the cube
+ * @param face the face to turn
+ * @param shift how many layers to turn, from 1 to _size_
+ * @param amount how many times to turn, from 1 to 3
+ * @returns the permutation
+ */
+const FaceletPermutation& getFaceletPermutation(uint16_t size, uint16_t face,
+                                                uint16_t shift,
+                                                uint16_t amount) {
+  auto &moves = getSizeMoves(size);
+  auto index = (face * size + shift - 1) * kMovePerAxis + amount - 1;
+  auto &ret = moves.moves[index];
+  call_once(moves.computed[index], [&ret, size, face, shift, amount] {
+    const auto faceSize = size * size;
+    vector<uint16_t> indices(kNFace * faceSize);
+    for (size_t i = 0; i < indices.size(); i++) {
+      indices[i] = i;
+    }
+    for (auto l = 1; l <= shift; l++) {
+      turnLayer(&indices, size, face, l, amount);
+    }
+    uint16_t opposite = (face + kNFace / 2) % kNFace;
+    for (size_t i = 0; i < indices.size(); i++) {
+      uint16_t f = i / faceSize;
+      if (f == face || (shift == size && f == opposite)) {
+        continue;
+      }
+      if (indices[i] != i) {
+        ret.targets.push_back(i);
+        ret.sources.push_back(indices[i]);
+      }
+    }
+  });
+  return ret;
+}
+
+#ifdef CUBE_UTIL_SSE2_KERNELS
+/**
+ * Transpose an 8x8 block of facelets with SSE2 byte shuffles.
+ * @param src first row of the block
+ * @param srcStride distance between the rows of the block
+ * @param dst first row of the transposed block
+ * @param dstStride distance between the rows of the transposed block
+ */
+void transposeBlock(const uint8_t *src, ptrdiff_t srcStride, uint8_t *dst,
+                    ptrdiff_t dstStride) {
+  auto row = [src, srcStride](int i) {
+    return _mm_loadl_epi64(
+        reinterpret_cast<const __m128i *>(src + i * srcStride));
+  };
+  // pairs of rows interleaved, then quads, then all 8
+  auto a0 = _mm_unpacklo_epi8(row(0), row(1));
+  auto a1 = _mm_unpacklo_epi8(row(2), row(3));
+  auto a2 = _mm_unpacklo_epi8(row(4), row(5));
+  auto a3 = _mm_unpacklo_epi8(row(6), row(7));
+  auto b0 = _mm_unpacklo_epi16(a0, a1);
+  auto b1 = _mm_unpackhi_epi16(a0, a1);
+  auto b2 = _mm_unpacklo_epi16(a2, a3);
+  auto b3 = _mm_unpackhi_epi16(a2, a3);
+  __m128i columns[] = {
+    _mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+    _mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3),
+  };
+  for (auto i = 0; i < 4; i++) {
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 2 * i * dstStride),
+                     columns[i]);
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i *>(dst + (2 * i + 1) * dstStride),
+        _mm_unpackhi_epi64(columns[i], columns[i]));
+  }
+}
+#endif
+
+/**
+ * Transpose an n x n face, with rows given by their strides so that rows
+ * may be walked backwards.
+ * @param src first row of the face
+ * @param srcStride distance between the rows of the face
+ * @param dst first row of the transposed face
+ * @param dstStride distance between the rows of the transposed face
+ * @param n size of the face
+ */
+void transposeFace(const uint8_t *src, ptrdiff_t srcStride, uint8_t *dst,
+                   ptrdiff_t dstStride, int n) {
+  auto blocked = 0;
+#ifdef CUBE_UTIL_SSE2_KERNELS
+  blocked = n & ~7;
+  for (auto i = 0; i < blocked; i += 8) {
+    for (auto j = 0; j < blocked; j += 8) {
+      transposeBlock(src + i * srcStride + j, srcStride,
+                     dst + j * dstStride + i, dstStride);
+    }
+  }
+#endif
+  for (auto i = 0; i < n; i++) {
+    for (auto j = i < blocked ? blocked : 0; j < n; j++) {
+      dst[j * dstStride + i] = src[i * srcStride + j];
+    }
+  }
+}
+
+/**
+ * Rotate a face clockwise. A quarter turn transposes the face walking either
+ * the source or the result rows backwards, and a half turn reverses it.
+ * @param face first facelet of the face
+ * @param n size of the face
+ * @param amount how many times to turn, from 1 to 3
+ */
+void rotateFace(uint8_t *face, int n, int amount) {
+  if (amount == 2) {
+    std::reverse(face, face + n * n);
+    return;
+  }
+  thread_local vector<uint8_t> buffer;
+  buffer.resize(n * n);
+  if (amount == 1) {
+    transposeFace(face + (n - 1) * n, -n, buffer.data(), n, n);
+  } else {
+    transposeFace(face, n, buffer.data() + (n - 1) * n, -n, n);
+  }
+  std::copy(buffer.begin(), buffer.end(), face);
+}
+
+}  // namespace
+
 FaceletCubeNNN::FaceletCubeNNN(uint16_t size) {
   if (size < 2 || size > kMaxSize) {
     throw invalid_argument("The size should between 2 and " +
         to_string(kMaxSize));
   }
   size_ = size;
-  facelets_ = vector<uint16_t>(kNFace * size * size);
+  facelets_ = vector<uint8_t>(kNFace * size * size);
   reset();
 }
 
@@ -50,8 +484,13 @@ FaceletCubeNNN::FaceletCubeNNN(uint16_t size,
     throw invalid_argument("The facelets definition length should be " +
         to_string(kNFace * size * size));
   }
+  if (std::any_of(facelets.begin(), facelets.end(),
+                  [](uint16_t f) { return f >= kNFace; })) {
+    throw invalid_argument("The facelets should be less than " +
+        to_string(kNFace));
+  }
   size_ = size;
-  facelets_ = facelets;
+  facelets_.assign(facelets.begin(), facelets.end());
 }
 
 uint16_t FaceletCubeNNN::getSize() const {
@@ -59,7 +498,7 @@ uint16_t FaceletCubeNNN::getSize() const {
 }
 
 vector<uint16_t> FaceletCubeNNN::getFacelets() const {
-  return facelets_;
+  return vector<uint16_t>(facelets_.begin(), facelets_.end());
 }
 
 string FaceletCubeNNN::getFaceletsString() const {
@@ -120,41 +559,7 @@ void FaceletCubeNNN::moveu(int layer, int amount) {
   if (amount < 1) {
     throw invalid_argument("Amount must be positive");
   }
-  amount = amount & 3;
-  for (auto c = 0; c < amount; c++) {
-    if (layer == 1) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              U * size_ * size_ + (i * size_) + j,
-              U * size_ * size_ + (j * size_) + (size_ - i - 1),
-              U * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              U * size_ * size_ + ((size_ - j - 1) * size_) + i);
-        }
-      }
-    }
-    for (int i = 0; i < size_; i++) {
-      cycle4(&facelets_,
-             F * size_ * size_ + (layer - 1) * size_ + i,
-             L * size_ * size_ + (layer - 1) * size_ + i,
-             B * size_ * size_ + (layer - 1) * size_ + i,
-             R * size_ * size_ + (layer - 1) * size_ + i);
-    }
-
-    if (layer == size_) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              D * size_ * size_ + (i * size_) + j,
-              D * size_ * size_ + ((size_ - j - 1) * size_) + i,
-              D * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              D * size_ * size_ + (j * size_) + (size_ - i - 1));
-        }
-      }
-    }
-  }
+  turnOneLayer(U, layer, amount);
 }
 
 void FaceletCubeNNN::moved(int layer, int amount) {
@@ -168,41 +573,7 @@ void FaceletCubeNNN::mover(int layer, int amount) {
   if (amount < 1) {
     throw invalid_argument("Amount must be positive");
   }
-  amount = amount & 3;
-  for (auto c = 0; c < amount; c++) {
-    if (layer == 1) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              R * size_ * size_ + (i * size_) + j,
-              R * size_ * size_ + (j * size_) + (size_ - i - 1),
-              R * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              R * size_ * size_ + ((size_ - j - 1) * size_) + i);
-        }
-      }
-    }
-    for (int i = 0; i < size_; i++) {
-      cycle4(&facelets_,
-             U * size_ * size_ + i * size_ + (size_ - layer),
-             B * size_ * size_ + (size_ - i - 1) * size_ + (layer - 1),
-             D * size_ * size_ + i * size_ + (size_ - layer),
-             F * size_ * size_ + i * size_ + (size_ - layer));
-    }
-
-    if (layer == size_) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              L * size_ * size_ + (i * size_) + j,
-              L * size_ * size_ + ((size_ - j - 1) * size_) + i,
-              L * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              L * size_ * size_ + (j * size_) + (size_ - i - 1));
-        }
-      }
-    }
-  }
+  turnOneLayer(R, layer, amount);
 }
 
 void FaceletCubeNNN::movel(int layer, int amount) {
@@ -216,69 +587,116 @@ void FaceletCubeNNN::movef(int layer, int amount) {
   if (amount < 1) {
     throw invalid_argument("Amount must be positive");
   }
-  amount = amount & 3;
-  for (auto c = 0; c < amount; c++) {
-    if (layer == 1) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              F * size_ * size_ + (i * size_) + j,
-              F * size_ * size_ + (j * size_) + (size_ - i - 1),
-              F * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              F * size_ * size_ + ((size_ - j - 1) * size_) + i);
-        }
-      }
+  turnOneLayer(F, layer, amount);
+}
+
+void FaceletCubeNNN::moveb(int layer, int amount) {
+  movef(size_ - layer + 1, 4 - (amount & 3));
+}
+
+void FaceletCubeNNN::turn(uint16_t face, int shift, int amount) {
+  amount &= 3;
+  if (amount == 0) {
+    return;
+  }
+  const auto &p = getFaceletPermutation(size_, face, shift, amount);
+  thread_local vector<uint8_t> buffer;
+  auto n = p.targets.size();
+  buffer.resize(n);
+  auto facelets = facelets_.data();
+  auto sources = p.sources.data();
+  auto targets = p.targets.data();
+  auto moved = buffer.data();
+  for (size_t i = 0; i < n; i++) {
+    moved[i] = facelets[sources[i]];
+  }
+  if (hash_.computed()) {
+    // the hash changes by the keys of the facelets replaced, found before
+    // storing any facelet, as the byte stores may alias the keys
+    auto keys = getSizeMoves(size_).keys.data();
+    uint64_t change = 0;
+    for (size_t i = 0; i < n; i++) {
+      auto t = targets[i];
+      change ^= keys[t * kNFace + facelets[t]] ^ keys[t * kNFace + moved[i]];
     }
-    for (int i = 0; i < size_; i++) {
-      cycle4(&facelets_,
-             U * size_ * size_ + (size_ - layer) * size_ + i,
-             R * size_ * size_ + i * size_ + (layer - 1),
-             D * size_ * size_ + (layer - 1) * size_ + (size_ - i - 1),
-             L * size_ * size_ + (size_ - i - 1) * size_ + (size_ - layer));
-    }
-
-    if (layer == size_) {
-      for (int i = 0; i < size_ / 2; i ++) {
-        for (int j = i; j < size_ - i - 1; j++) {
-          cycle4(
-              &facelets_,
-              B * size_ * size_ + (i * size_) + j,
-              B * size_ * size_ + ((size_ - j - 1) * size_) + i,
-              B * size_ * size_ + ((size_ - i - 1) * size_) + (size_ - j - 1),
-              B * size_ * size_ + (j * size_) + (size_ - i - 1));
-        }
-      }
+    hash_.update(change);
+  }
+  for (size_t i = 0; i < n; i++) {
+    facelets[targets[i]] = moved[i];
+  }
+  // the faces turned as a whole are rotated right away; recording the turns
+  // per face and looking every facelet up through them cost more, as the
+  // side facelets of wide turns outnumber those of a face
+  turnFace(face, amount);
+  if (shift == size_) {
+    turnFace((face + kNFace / 2) % kNFace, 4 - amount);
+  }
+}
+
+void FaceletCubeNNN::turnFace(uint16_t face, int amount) {
+  if (hash_.computed()) {
+    hash_.update(faceKeys(face));
+  }
+  rotateFace(&facelets_[face * size_ * size_], size_, amount);
+  if (hash_.computed()) {
+    hash_.update(faceKeys(face));
+  }
+}
+
+void FaceletCubeNNN::turnOneLayer(uint16_t face, int layer, int amount) {
+  // the keys of the facelets of the layer before and after the turn
+  uint64_t change = 0;
+  const auto &keys = getSizeMoves(size_).keys;
+  auto addKeys = [this, &keys, &change](int a, int b, int c, int d) {
+    for (auto i : {a, b, c, d}) {
+      change ^= keys[i * kNFace + facelets_[i]];
     }
+  };
+  if (hash_.computed()) {
+    turnLayer(size_, face, layer, 1, addKeys);
+  }
+  turnLayer(&facelets_, size_, face, layer, amount & 3);
+  if (hash_.computed()) {
+    turnLayer(size_, face, layer, 1, addKeys);
+    hash_.update(change);
   }
 }
 
-void FaceletCubeNNN::moveb(int layer, int amount) {
-  movef(size_ - layer + 1, 4 - (amount & 3));
+uint64_t FaceletCubeNNN::faceKeys(uint16_t face) const {
+  const auto &keys = getSizeMoves(size_).keys;
+  const auto faceSize = size_ * size_;
+  uint64_t ret = 0;
+  for (auto i = face * faceSize; i < (face + 1) * faceSize; i++) {
+    ret ^= keys[i * kNFace + facelets_[i]];
+  }
+  return ret;
 }
 
 void FaceletCubeNNN::moveU(int amount) {
-  moveu(1, amount);
+  checkAmount(amount);
+  turn(U, 1, amount);
 }
 
 void FaceletCubeNNN::moveR(int amount) {
-  mover(1, amount);
+  checkAmount(amount);
+  turn(R, 1, amount);
 }
 
 void FaceletCubeNNN::moveF(int amount) {
-  movef(1, amount);
+  checkAmount(amount);
+  turn(F, 1, amount);
 }
 
 void FaceletCubeNNN::moveD(int amount) {
-  moved(1, amount);
+  turn(D, 1, amount);
 }
 
 void FaceletCubeNNN::moveL(int amount) {
-  movel(1, amount);
+  turn(L, 1, amount);
 }
 
 void FaceletCubeNNN::moveB(int amount) {
-  moveb(1, amount);
+  turn(B, 1, amount);
 }
 
 void FaceletCubeNNN::moveU() {
@@ -312,9 +730,8 @@ void FaceletCubeNNN::moveUw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    moveu(l, amount);
-  }
+  checkAmount(amount);
+  turn(U, shift, amount);
 }
 
 void FaceletCubeNNN::moveRw(int shift, int amount) {
@@ -324,9 +741,8 @@ void FaceletCubeNNN::moveRw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    mover(l, amount);
-  }
+  checkAmount(amount);
+  turn(R, shift, amount);
 }
 
 void FaceletCubeNNN::moveFw(int shift, int amount) {
@@ -336,9 +752,8 @@ void FaceletCubeNNN::moveFw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    movef(l, amount);
-  }
+  checkAmount(amount);
+  turn(F, shift, amount);
 }
 
 void FaceletCubeNNN::moveDw(int shift, int amount) {
@@ -348,9 +763,7 @@ void FaceletCubeNNN::moveDw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    moved(l, amount);
-  }
+  turn(D, shift, amount);
 }
 
 void FaceletCubeNNN::moveLw(int shift, int amount) {
@@ -360,9 +773,7 @@ void FaceletCubeNNN::moveLw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    movel(l, amount);
-  }
+  turn(L, shift, amount);
 }
 
 void FaceletCubeNNN::moveBw(int shift, int amount) {
@@ -372,9 +783,7 @@ void FaceletCubeNNN::moveBw(int shift, int amount) {
   if (shift < 2) {
     shift = 2;
   }
-  for (auto l = 1; l <= shift; l++) {
-    moveb(l, amount);
-  }
+  turn(B, shift, amount);
 }
 
 void FaceletCubeNNN::moveUw(int amount) {
@@ -454,22 +863,131 @@ void FaceletCubeNNN::reset() {
   for (auto i = 0; i < kNFace; i++) {
     fill_n(facelets_.begin() + i * size_ * size_, size_ * size_, i);
   }
+  hash_.clear();
 }
 
 bool FaceletCubeNNN::isSolvableIn(uint16_t max_length) const {
   if (max_length > 2) {
     throw invalid_argument("Max check length is 2");
   }
-  auto ifcn = FaceletCubeNNN(size_);
-  if (*this == ifcn) {
+  if (isSolved()) {
     return true;
   }
-  if (max_length > 0) {
-    const uint16_t kNMove = (size_ - 1) * 9;
-    for (auto m = 0; m < kNMove; m++) {
-      auto another = FaceletCubeNNN(size_, facelets_);
+  if (max_length == 0) {
+    return false;
+  }
+
+  // a move only changes the facelets in its layers, so the facelets out of
+  // place have to lie in the layers of the moves solving the cube, and only
+  // moves passing this check are tried
+  const int n = size_;
+  const uint16_t nMove = (size_ - 1) * 9;
+  const uint16_t nPair = kNAxis / 2;
+  const auto nFacelets = kNFace * n * n;
+  const auto &layers = getSizeMoves(size_).layers;
+  array<int, kNFace> maxShift = {};
+  for (auto m = 0; m < nMove; m++) {
+    auto face = (m / kMovePerAxis) % kNAxis;
+    maxShift[face] = std::max(maxShift[face], m / kMovePerShift + 1);
+  }
+  // whether some move turning the outer layers of _face_ turns all the
+  // layers in _range_, along the axis of the face
+  auto covers = [n](uint16_t face, int shift, const LayerRange &range) {
+    return range.empty() ||
+           (face < kNAxis / 2 ? range.hi < shift : range.lo >= n - shift);
+  };
+
+  // mark the pairs of layers along two axes holding facelets out of place,
+  // with stores only so that facelets in the same layers do not wait for
+  // each other
+  vector<uint8_t> marked(nPair * nPair * n * n);
+  for (auto f = 0; f < kNFace; f++) {
+    for (auto i = f * n * n; i < (f + 1) * n * n; i++) {
+      if (facelets_[i] == f) {
+        continue;
+      }
+      array<int, kNAxis / 2> l;
+      for (auto axis = 0; axis < nPair; axis++) {
+        l[axis] = layers[axis * nFacelets + i];
+      }
+      for (auto axis = 0; axis < nPair; axis++) {
+        for (auto a = 0; a < nPair; a++) {
+          marked[((axis * nPair + a) * n + l[axis]) * n + l[a]] = 1;
+        }
+      }
+    }
+  }
+  // ranges[(axis * n + layer) * nPair + a] holds the range along axis a of
+  // the facelets out of place in the layer along axis
+  vector<LayerRange> ranges(nPair * n * nPair);
+  array<LayerRange, kNAxis / 2> total;
+  for (auto axis = 0; axis < nPair; axis++) {
+    for (auto l = 0; l < n; l++) {
+      for (auto a = 0; a < nPair; a++) {
+        auto row = &marked[((axis * nPair + a) * n + l) * n];
+        for (auto la = 0; la < n; la++) {
+          if (row[la] != 0) {
+            ranges[(axis * n + l) * nPair + a].add(la);
+          }
+        }
+      }
+      total[axis].add(ranges[(axis * n + l) * nPair + axis]);
+    }
+  }
+
+  for (auto m = 0; m < nMove; m++) {
+    uint16_t face = (m / kMovePerAxis) % kNAxis;
+    if (covers(face, m / kMovePerShift + 1, total[face % nPair])) {
+      auto another = *this;
       another.move(m);
-      if (another.isSolvableIn(max_length - 1)) {
+      if (another.isSolved()) {
+        return true;
+      }
+    }
+  }
+  if (max_length == 1) {
+    return false;
+  }
+
+  // ranges of the facelets out of place in the layers before and after each
+  // layer, so that those left by the layers of a move come at once
+  vector<LayerRange> before(nPair * (n + 1) * nPair);
+  vector<LayerRange> after(nPair * (n + 1) * nPair);
+  for (auto axis = 0; axis < nPair; axis++) {
+    for (auto a = 0; a < nPair; a++) {
+      for (auto l = 0; l < n; l++) {
+        before[(axis * (n + 1) + l + 1) * nPair + a] =
+            before[(axis * (n + 1) + l) * nPair + a];
+        before[(axis * (n + 1) + l + 1) * nPair + a].add(
+            ranges[(axis * n + l) * nPair + a]);
+      }
+      for (auto l = n - 1; l >= 0; l--) {
+        after[(axis * (n + 1) + l) * nPair + a] =
+            after[(axis * (n + 1) + l + 1) * nPair + a];
+        after[(axis * (n + 1) + l) * nPair + a].add(
+            ranges[(axis * n + l) * nPair + a]);
+      }
+    }
+  }
+  for (auto m = 0; m < nMove; m += kMovePerAxis) {
+    uint16_t face = (m / kMovePerAxis) % kNAxis;
+    auto shift = m / kMovePerShift + 1;
+    auto axis = face % nPair;
+    // the facelets out of place the last move leaves need to be turned by
+    // the first one
+    auto left = face < nPair ? &after[(axis * (n + 1) + shift) * nPair]
+                             : &before[(axis * (n + 1) + n - shift) * nPair];
+    auto solvable = false;
+    for (uint16_t f = 0; f < kNFace && !solvable; f++) {
+      solvable = covers(f, maxShift[f], left[f % nPair]);
+    }
+    if (!solvable) {
+      continue;
+    }
+    for (auto amount = 0; amount < kMovePerAxis; amount++) {
+      auto another = *this;
+      another.move(m + amount);
+      if (another.isSolvableIn(1)) {
         return true;
       }
     }
@@ -477,8 +995,38 @@ bool FaceletCubeNNN::isSolvableIn(uint16_t max_length) const {
   return false;
 }
 
+bool FaceletCubeNNN::isSolved() const {
+  const auto faceSize = size_ * size_;
+  for (auto f = 0; f < kNFace; f++) {
+    auto begin = facelets_.begin() + f * faceSize;
+    if (std::find_if(begin, begin + faceSize, [f](uint8_t c) {
+          return c != f;
+        }) != begin + faceSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t FaceletCubeNNN::hash() const {
+  if (!hash_.computed()) {
+    uint64_t ret = 0;
+    for (uint16_t f = 0; f < kNFace; f++) {
+      ret ^= faceKeys(f);
+    }
+    hash_.set(ret);
+    return ret;
+  }
+  return hash_.value();
+}
+
 bool FaceletCubeNNN::operator==(const FaceletCubeNNN &that) const {
-  return size_ == that.size_ && facelets_ == that.facelets_;
+  if (size_ != that.size_ ||
+      (hash_.computed() && that.hash_.computed() &&
+       hash_.value() != that.hash_.value())) {
+    return false;
+  }
+  return facelets_ == that.facelets_;
 }
 
 ostream& operator<<(ostream &os, const FaceletCubeNNN &fc) {
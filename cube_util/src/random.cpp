@@ -0,0 +1,95 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/random.hpp"
+
+#include <random>
+
+namespace cube_util {
+
+using std::random_device;
+
+namespace {
+
+/**
+ * Get the next number of a splitmix64 sequence, used to expand seeds.
+ * @param[inout] x state of the sequence
+ * @returns the next number
+ */
+uint64_t splitMix64(uint64_t *x) {
+  auto z = (*x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Rotate a 64-bit number left.
+ * @param x the number
+ * @param k bits to rotate by, 0 < k < 64
+ * @returns the rotated number
+ */
+inline uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Get the engine of the calling thread.
+ * @returns reference to the engine
+ */
+Xoshiro256& threadEngine() {
+  thread_local Xoshiro256 engine([] {
+    random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+  }());
+  return engine;
+}
+
+}  // namespace
+
+uint64_t RandomEngine::uniform(uint64_t bound) {
+  // reject the lowest numbers so that the rest is a multiple of `bound`
+  auto threshold = (0 - bound) % bound;
+  uint64_t r;
+  do {
+    r = next();
+  } while (r < threshold);
+  return r % bound;
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+  this->seed(seed);
+}
+
+void Xoshiro256::seed(uint64_t seed) {
+  for (auto &s : state_) {
+    s = splitMix64(&seed);
+  }
+}
+
+uint64_t Xoshiro256::next() {
+  auto ret = rotl(state_[1] * 5, 7) * 9;
+  auto t = state_[1] << 17;
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+  state_[2] ^= t;
+  state_[3] = rotl(state_[3], 45);
+  return ret;
+}
+
+uint64_t deriveSeed(uint64_t seed, uint64_t key) {
+  auto x = seed;
+  auto mixed = splitMix64(&x);
+  x = mixed ^ key;
+  return splitMix64(&x);
+}
+
+RandomEngine& threadRandomEngine() {
+  return threadEngine();
+}
+
+void seedThreadRandomEngine(uint64_t seed) {
+  threadEngine().seed(seed);
+}
+
+}  // namespace cube_util
@@ -0,0 +1,143 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/scramble/pooled_scrambler.hpp"
+
+#include <utility>
+
+namespace cube_util {
+
+using std::atomic_thread_fence;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::current_exception;
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::memory_order_seq_cst;
+using std::rethrow_exception;
+using std::unique_lock;
+
+PooledScrambler::PooledScrambler(function<unique_ptr<Scrambler>()> factory,
+                                 size_t capacity, uint16_t nThreads)
+    : factory_(std::move(factory)), queue_(capacity), stopping_(false),
+      sleeping_(0), low_water_mark_(capacity), produced_(0), served_(0),
+      fallbacks_(0), busy_nanos_(0), failed_producers_(0) {
+  if (nThreads == 0) {
+    nThreads = thread::hardware_concurrency();
+  }
+  if (nThreads == 0) {
+    nThreads = 1;
+  }
+  for (auto i = 0; i < nThreads; i++) {
+    threads_.emplace_back(&PooledScrambler::produce, this);
+  }
+}
+
+PooledScrambler::PooledScrambler(uint16_t size, size_t capacity,
+                                 uint16_t nThreads)
+    : PooledScrambler([size] { return Scrambler::instance(size); }, capacity,
+                      nThreads) {}
+
+PooledScrambler::~PooledScrambler() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+unique_ptr<MoveSequence> PooledScrambler::scramble() {
+  unique_ptr<MoveSequence> ret;
+  size_t left = 0;
+  if (queue_.pop(&ret)) {
+    left = queue_.size();
+    // pairs with the fence in produce(), so that either the producer sees
+    // the room made by this pop, or this sees the producer sleeping
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleeping_.load(memory_order_relaxed) > 0) {
+      { lock_guard<mutex> lock(mutex_); }
+      wake_.notify_one();
+    }
+  } else {
+    // pairs with the release in produce(), so that the error is set
+    if (failed_producers_.load(memory_order_acquire) == threads_.size()) {
+      lock_guard<mutex> lock(mutex_);
+      rethrow_exception(error_);
+    }
+    fallbacks_.fetch_add(1, memory_order_relaxed);
+    ret = factory_()->scramble();
+  }
+  served_.fetch_add(1, memory_order_relaxed);
+  auto mark = low_water_mark_.load(memory_order_relaxed);
+  while (left < mark &&
+         !low_water_mark_.compare_exchange_weak(mark, left,
+                                                memory_order_relaxed)) {}
+  return ret;
+}
+
+PooledScrambler::Metrics PooledScrambler::getMetrics() const {
+  Metrics ret;
+  ret.size = queue_.size();
+  ret.capacity = queue_.capacity();
+  ret.lowWaterMark = low_water_mark_.load(memory_order_relaxed);
+  ret.produced = produced_.load(memory_order_relaxed);
+  ret.served = served_.load(memory_order_relaxed);
+  ret.fallbacks = fallbacks_.load(memory_order_relaxed);
+  ret.failedProducers = failed_producers_.load(memory_order_relaxed);
+  auto busy = busy_nanos_.load(memory_order_relaxed);
+  ret.refillRate = busy == 0 ? 0 :
+      ret.produced * 1e9 * (threads_.size() - ret.failedProducers) / busy;
+  return ret;
+}
+
+void PooledScrambler::resetMetrics() {
+  low_water_mark_.store(queue_.size(), memory_order_relaxed);
+  produced_.store(0, memory_order_relaxed);
+  served_.store(0, memory_order_relaxed);
+  fallbacks_.store(0, memory_order_relaxed);
+  busy_nanos_.store(0, memory_order_relaxed);
+}
+
+/**
+ * Main loop of a producer thread. A producer whose scrambler throws stops,
+ * keeping the exception if it's the first one, and scramble() falls back to
+ * inline generation then.
+ */
+void PooledScrambler::produce() {
+  try {
+    auto scrambler = factory_();
+    unique_ptr<MoveSequence> ready;
+    while (!stopping_.load(memory_order_relaxed)) {
+      if (ready == nullptr) {
+        auto start = clock::now();
+        ready = scrambler->scramble();
+        auto elapsed = duration_cast<nanoseconds>(clock::now() - start);
+        busy_nanos_.fetch_add(elapsed.count(), memory_order_relaxed);
+        produced_.fetch_add(1, memory_order_relaxed);
+      }
+      if (queue_.push(&ready)) {
+        continue;
+      }
+      unique_lock<mutex> lock(mutex_);
+      sleeping_.fetch_add(1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_seq_cst);
+      wake_.wait(lock, [this] {
+        return stopping_ || queue_.size() < queue_.capacity();
+      });
+      sleeping_.fetch_sub(1, memory_order_relaxed);
+    }
+  } catch (...) {
+    {
+      lock_guard<mutex> lock(mutex_);
+      if (error_ == nullptr) {
+        error_ = current_exception();
+      }
+    }
+    failed_producers_.fetch_add(1, memory_order_release);
+  }
+}
+
+}  // namespace cube_util
@@ -7,12 +7,42 @@
 
 namespace cube_util {
 
+using std::make_shared;
 using std::make_unique;
 
 Scrambler::Scrambler(bool wca_check) {
   wca_check_ = wca_check;
 }
 
+void Scrambler::setRandomEngine(shared_ptr<RandomEngine> random) {
+  random_ = random;
+}
+
+void Scrambler::seed(uint64_t seed) {
+  random_ = make_shared<Xoshiro256>(seed);
+}
+
+unique_ptr<MoveSequence> Scrambler::scrambleAt(uint64_t masterSeed,
+                                               uint64_t set,
+                                               uint64_t index) {
+  auto saved = random_;
+  random_ = make_shared<Xoshiro256>(
+      deriveSeed(deriveSeed(masterSeed, set), index));
+  unique_ptr<MoveSequence> ret;
+  try {
+    ret = scramble();
+  } catch (...) {
+    random_ = saved;
+    throw;
+  }
+  random_ = saved;
+  return ret;
+}
+
+RandomEngine* Scrambler::random() const {
+  return random_ != nullptr ? random_.get() : &threadRandomEngine();
+}
+
 unique_ptr<Scrambler> Scrambler::instance(uint16_t size) {
   switch (size) {
     case 2:
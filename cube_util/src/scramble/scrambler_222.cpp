@@ -18,7 +18,8 @@ Scrambler222::Scrambler222(uint16_t minScrambleLength) : Scrambler(true) {
 unique_ptr<MoveSequence> Scrambler222::scramble() {
   Cube222Solver s;
   do {
-    s = Cube222Solver(CubieCube222::randomCube());
+    s = Cube222Solver(CubieCube222::randomCube(random()));
+    s.setDistanceTable(true);
   } while (wca_check_ && s.isSolvableIn(min_state_length_ - 1));
   return s.generate(min_scramble_length_);
 }
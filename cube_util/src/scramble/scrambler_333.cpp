@@ -16,8 +16,9 @@ Scrambler333::Scrambler333(uint16_t maxScrambleLength) : Scrambler(true) {
 unique_ptr<MoveSequence> Scrambler333::scramble() {
   Cube333Solver s;
   do {
-    s = Cube333Solver(CubieCube333::randomCube());
+    s = Cube333Solver(CubieCube333::randomCube(random()));
   } while (wca_check_ && s.isSolvableIn(min_scramble_length_ - 1));
+  s.setSixWaySearch(true);
   return s.generate(max_scramble_length_);
 }
 
@@ -17,8 +17,6 @@ using constants::kMovePerAxis;
 using constants::kMovePerShift;
 using constants::kNAxis;
 
-using utils::randomizer;
-
 ScramblerNNN::ScramblerNNN(uint16_t cube_size) : Scrambler(true) {
   if (cube_size <= kMaxRandomStateCubeSize) {
     throw invalid_argument("Cube smaller than " +
@@ -41,9 +39,9 @@ unique_ptr<MoveSequence> ScramblerNNN::scramble() {
     uint16_t count = 0;
     int16_t last_axis = -1;
     auto turned = vector<bool>(cube_size_ - 1, false);
-    auto r = randomizer(0, 3 * kMovePerAxis * (cube_size_ - 1) - 1);
+    auto nMove = 3 * kMovePerAxis * (cube_size_ - 1);
     while (count < scramble_length_) {
-      auto move = r();
+      uint16_t move = random()->uniform(nMove);
       auto axis = (move / kMovePerAxis) % kNAxis;
       auto shift = move / kMovePerShift;
 
@@ -0,0 +1,33 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/search_stats.hpp"
+
+namespace cube_util {
+
+double SearchStats::phase1Seconds() const {
+  return searchSeconds - phase2Seconds;
+}
+
+uint64_t SearchStats::nodes() const {
+  uint64_t ret = 0;
+  for (auto i = 0; i < kMaxStatsDepth; i++) {
+    ret += phase1Nodes[i] + phase2Nodes[i];
+  }
+  return ret;
+}
+
+SearchStats& SearchStats::operator+=(const SearchStats &other) {
+  for (auto i = 0; i < kMaxStatsDepth; i++) {
+    phase1Nodes[i] += other.phase1Nodes[i];
+    phase2Nodes[i] += other.phase2Nodes[i];
+  }
+  pruningLookups += other.pruningLookups;
+  phase2Entries += other.phase2Entries;
+  phase2Rejections += other.phase2Rejections;
+  phase1Lengths += other.phase1Lengths;
+  seconds += other.seconds;
+  searchSeconds += other.searchSeconds;
+  phase2Seconds += other.phase2Seconds;
+  return *this;
+}
+
+}  // namespace cube_util
@@ -0,0 +1,78 @@
+// Copyright 2019 Yunqi Ouyang
+#ifndef CUBE_UTIL_SRC_TABLE_LOADERS_HPP_
+#define CUBE_UTIL_SRC_TABLE_LOADERS_HPP_
+#include <cstdint>
+
+#include <functional>
+#include <vector>
+
+#include "cube_util/thread_pool.hpp"
+
+namespace cube_util {
+namespace tables {
+
+using std::function;
+using std::vector;
+
+/** Tables of fewer states are generated on the thread loading them */
+const uint32_t kParallelTableStates = 1 << 22;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Sets the pool generating the big tables the calling thread loads, for as
+/// long as the scope lives. Without a scope, big tables are generated on a
+/// pool of all hardware threads shared by the process.
+////////////////////////////////////////////////////////////////////////////////
+class BuildPoolScope {
+  /** Whether a scope was set before this one */
+  bool previous_set_;
+
+  /** Pool of the scope set before this one */
+  ThreadPool *previous_pool_;
+
+ public:
+  /**
+   * Constructor of the class.
+   * @param pool the pool, or nullptr to generate all tables on the calling
+   * thread
+   */
+  explicit BuildPoolScope(ThreadPool *pool);
+
+  BuildPoolScope(const BuildPoolScope &) = delete;
+
+  BuildPoolScope& operator=(const BuildPoolScope &) = delete;
+
+  ~BuildPoolScope();
+};
+
+/**
+ * Get the pool to generate a table on, see BuildPoolScope.
+ * @param nStates number of states of the table
+ * @returns the pool, or nullptr to generate the table on the calling thread
+ */
+ThreadPool* getBuildPool(uint32_t nStates);
+
+/**
+ * Get functions loading each table used by the 2x2x2 solver.
+ * A table is listed after the tables it depends on.
+ * @returns the loaders
+ */
+vector<function<void()>> get222TableLoaders();
+
+/**
+ * Get functions loading each table used by the 3x3x3 solver, except the one
+ * used by Cube333Solver::setSymmetryPruning().
+ * A table is listed after the tables it depends on.
+ * @returns the loaders
+ */
+vector<function<void()>> get333TableLoaders();
+
+/**
+ * Load the table used by Cube333Solver::setSymmetryPruning(), which is the
+ * only table of at least #kParallelTableStates states.
+ */
+void load333SymmetryTable();
+
+}  // namespace tables
+}  // namespace cube_util
+
+#endif  // CUBE_UTIL_SRC_TABLE_LOADERS_HPP_
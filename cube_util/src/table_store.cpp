@@ -0,0 +1,363 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/table_store.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "table_loaders.hpp"
+
+namespace cube_util {
+namespace tables {
+
+using std::invalid_argument;
+using std::list;
+using std::lock_guard;
+using std::mutex;
+using std::ofstream;
+using std::to_string;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace {
+
+/** Magic number at the beginning of a table file, "CUTB" */
+const uint32_t kTableMagic = 0x42545543;
+
+/** Header of a table file, followed by the table content */
+struct TableHeader {
+  uint32_t magic;
+  uint32_t format;
+  char name[kMaxTableNameLength + 1];
+  uint64_t elementSize;
+  uint64_t count;
+  uint64_t checksum;
+};
+
+/** Guards the table directory and the loaded tables */
+mutex storeMutex;
+
+/** Whether a BuildPoolScope is set on the calling thread */
+thread_local bool buildPoolSet = false;
+
+/** Pool of the BuildPoolScope set on the calling thread */
+thread_local ThreadPool *buildPool = nullptr;
+
+/** Information of the loaded tables */
+vector<TableInfo> loadedTables;
+
+/**
+ * Get the table directory setting.
+ * @returns reference to the setting
+ */
+string& tableDirectory() {
+  static auto directory = [] {
+    auto env = getenv("CUBE_UTIL_TABLE_DIR");
+    return env == nullptr ? string() : string(env);
+  }();
+  return directory;
+}
+
+/**
+ * Check whether an environment variable enables a setting.
+ * @param name name of the variable
+ * @returns whether the variable is set to a value other than `0`
+ */
+bool envEnabled(const char *name) {
+  auto env = getenv(name);
+  return env != nullptr && *env != '\0' && strcmp(env, "0") != 0;
+}
+
+/**
+ * Get the huge pages setting.
+ * @returns reference to the setting
+ */
+bool& hugePages() {
+  static auto enabled = envEnabled("CUBE_UTIL_HUGE_PAGES");
+  return enabled;
+}
+
+/**
+ * Get the table verification setting.
+ * @returns reference to the setting
+ */
+bool& verifyTables() {
+  static auto enabled = envEnabled("CUBE_UTIL_VERIFY_TABLES");
+  return enabled;
+}
+
+/**
+ * Allocate zero-initialized memory aligned to and advised to use huge pages.
+ * The memory is never freed, as tables live as long as the process.
+ * @param bytes size of the memory
+ * @returns pointer to the memory, or nullptr if it's not available
+ */
+void* allocateHugePages(size_t bytes) {
+  auto size = (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  // over-allocate to align the start to a huge page
+  auto addr = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  auto offset = reinterpret_cast<uintptr_t>(addr) % kHugePageSize;
+  auto ret = static_cast<char*>(addr) + (kHugePageSize - offset) %
+      kHugePageSize;
+#ifdef MADV_HUGEPAGE
+  madvise(ret, size, MADV_HUGEPAGE);
+#endif
+  return ret;
+}
+
+/**
+ * Calculate checksum of table content, using 64-bit FNV-1a on whole words.
+ * @param data the content
+ * @param bytes size of the content
+ * @returns the checksum
+ */
+uint64_t checksum(const void *data, size_t bytes) {
+  const uint64_t prime = 0x100000001b3;
+  uint64_t ret = 0xcbf29ce484222325;
+  auto p = static_cast<const unsigned char*>(data);
+  for (; bytes >= 8; p += 8, bytes -= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    ret = (ret ^ word) * prime;
+  }
+  for (; bytes > 0; p++, bytes--) {
+    ret = (ret ^ *p) * prime;
+  }
+  return ret;
+}
+
+/**
+ * Make the header for a table.
+ * @param name name of the table
+ * @param elementSize size of each element in bytes
+ * @param count number of elements
+ * @param sum checksum of the content
+ * @returns the header
+ */
+TableHeader makeHeader(const string &name, size_t elementSize, size_t count,
+                       uint64_t sum) {
+  TableHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kTableMagic;
+  header.format = kTableFormatVersion;
+  name.copy(header.name, kMaxTableNameLength);
+  header.elementSize = elementSize;
+  header.count = count;
+  header.checksum = sum;
+  return header;
+}
+
+/**
+ * Map a table file into memory if it matches the table to load. Only the
+ * header and the file size are checked unless _verify_ is set, so that
+ * loading touches just the pages the lookups need.
+ * @param path path of the file
+ * @param expected header of the table to load, without checksum
+ * @param verify whether to check the content against the checksum in the
+ * file, reading the whole file
+ * @returns pointer to the table content, or nullptr if the file is missing
+ * or stale
+ */
+const void* mapTable(const string &path, const TableHeader &expected,
+                     bool verify) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  auto bytes = expected.elementSize * expected.count;
+  auto fileSize = sizeof(TableHeader) + bytes;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != fileSize) {
+    close(fd);
+    return nullptr;
+  }
+  auto addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto header = static_cast<const TableHeader*>(addr);
+  auto content = static_cast<const char*>(addr) + sizeof(TableHeader);
+  if (header->magic != expected.magic || header->format != expected.format ||
+      memcmp(header->name, expected.name, sizeof(expected.name)) != 0 ||
+      header->elementSize != expected.elementSize ||
+      header->count != expected.count ||
+      (verify && header->checksum != checksum(content, bytes))) {
+    munmap(addr, fileSize);
+    return nullptr;
+  }
+  return content;
+}
+
+/**
+ * Save a table file. The file is written under a temporary name, checked
+ * against the checksum in the header and then renamed, so other processes
+ * never see a partial or corrupt file. Failures are ignored since the table
+ * is already available in memory.
+ * @param path path of the file
+ * @param header header of the table
+ * @param data table content
+ */
+void saveTable(const string &path, const TableHeader &header,
+               const void *data) {
+  auto tmpPath = path + ".tmp" + to_string(getpid());
+  {
+    ofstream out(tmpPath, ofstream::binary | ofstream::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(static_cast<const char*>(data),
+              header.elementSize * header.count);
+    if (out.good()) {
+      out.close();
+      auto written = out.good() ? mapTable(tmpPath, header, true) : nullptr;
+      if (written != nullptr) {
+        munmap(const_cast<char*>(static_cast<const char*>(written)) -
+               sizeof(TableHeader), sizeof(TableHeader) +
+               header.elementSize * header.count);
+        if (rename(tmpPath.c_str(), path.c_str()) == 0) {
+          return;
+        }
+      }
+    }
+  }
+  remove(tmpPath.c_str());
+}
+
+}  // namespace
+
+void setTableDirectory(const string &directory) {
+  lock_guard<mutex> lock(storeMutex);
+  tableDirectory() = directory;
+}
+
+string getTableDirectory() {
+  lock_guard<mutex> lock(storeMutex);
+  return tableDirectory();
+}
+
+void setHugePages(bool enabled) {
+  lock_guard<mutex> lock(storeMutex);
+  hugePages() = enabled;
+}
+
+bool getHugePages() {
+  lock_guard<mutex> lock(storeMutex);
+  return hugePages();
+}
+
+void setVerifyTables(bool enabled) {
+  lock_guard<mutex> lock(storeMutex);
+  verifyTables() = enabled;
+}
+
+bool getVerifyTables() {
+  lock_guard<mutex> lock(storeMutex);
+  return verifyTables();
+}
+
+BuildPoolScope::BuildPoolScope(ThreadPool *pool)
+    : previous_set_(buildPoolSet), previous_pool_(buildPool) {
+  buildPoolSet = true;
+  buildPool = pool;
+}
+
+BuildPoolScope::~BuildPoolScope() {
+  buildPoolSet = previous_set_;
+  buildPool = previous_pool_;
+}
+
+ThreadPool* getBuildPool(uint32_t nStates) {
+  if (nStates < kParallelTableStates) {
+    return nullptr;
+  }
+  if (buildPoolSet) {
+    return buildPool;
+  }
+  static ThreadPool pool;
+  return &pool;
+}
+
+vector<TableInfo> getLoadedTables() {
+  lock_guard<mutex> lock(storeMutex);
+  return loadedTables;
+}
+
+void recordBuiltTable(const string &name, size_t bytes, double seconds) {
+  lock_guard<mutex> lock(storeMutex);
+  loadedTables.push_back({name, bytes, seconds, false, false});
+}
+
+const void* loadRawTable(const string &name, size_t elementSize, size_t count,
+                         const function<void(void *)> &generate) {
+  if (name.empty() || name.size() > kMaxTableNameLength) {
+    throw invalid_argument("invalid table name: " + name);
+  }
+  auto start = steady_clock::now();
+  auto bytes = elementSize * count;
+  void *huge = nullptr;
+  if (getHugePages() && bytes >= kHugePageSize) {
+    huge = allocateHugePages(bytes);
+  }
+  auto addInfo = [&](bool mapped) {
+    duration<double> seconds = steady_clock::now() - start;
+    loadedTables.push_back({name, bytes, seconds.count(), mapped,
+                            huge != nullptr});
+  };
+
+  auto directory = getTableDirectory();
+  auto path = directory + "/" + name + ".tbl";
+  auto header = makeHeader(name, elementSize, count, 0);
+  if (!directory.empty()) {
+    auto mapped = mapTable(path, header, getVerifyTables());
+    if (mapped != nullptr) {
+      if (huge != nullptr) {
+        memcpy(huge, mapped, bytes);
+        munmap(const_cast<char*>(static_cast<const char*>(mapped)) -
+               sizeof(TableHeader), sizeof(TableHeader) + bytes);
+        mapped = huge;
+      }
+      lock_guard<mutex> lock(storeMutex);
+      addInfo(true);
+      return mapped;
+    }
+  }
+
+  // tables live as long as the process, as function-local statics do
+  static list<vector<uint64_t>> generatedTables;
+  vector<uint64_t> data;
+  auto table = huge;
+  if (table == nullptr) {
+    data.assign((bytes + 7) / 8, 0);
+    table = data.data();
+  }
+  generate(table);
+  if (!directory.empty()) {
+    mkdir(directory.c_str(), 0755);
+    header.checksum = checksum(table, bytes);
+    saveTable(path, header, table);
+  }
+  lock_guard<mutex> lock(storeMutex);
+  addInfo(false);
+  if (huge == nullptr) {
+    generatedTables.push_back(std::move(data));
+  }
+  return table;
+}
+
+}  // namespace tables
+}  // namespace cube_util
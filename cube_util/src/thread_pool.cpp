@@ -0,0 +1,107 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/thread_pool.hpp"
+
+namespace cube_util {
+
+using std::current_exception;
+using std::lock_guard;
+using std::memory_order_relaxed;
+using std::rethrow_exception;
+using std::unique_lock;
+
+ThreadPool::ThreadPool(uint16_t nThreads) : next_task_(0) {
+  if (nThreads == 0) {
+    nThreads = thread::hardware_concurrency();
+  }
+  if (nThreads == 0) {
+    nThreads = 1;
+  }
+  for (auto i = 1; i < nThreads; i++) {
+    threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+uint16_t ThreadPool::size() const {
+  return threads_.size() + 1;
+}
+
+void ThreadPool::run(uint32_t nTasks,
+                     const function<void(uint32_t, uint16_t)> &task) {
+  lock_guard<mutex> runLock(run_mutex_);
+  {
+    lock_guard<mutex> lock(mutex_);
+    task_ = &task;
+    n_tasks_ = nTasks;
+    next_task_.store(0, memory_order_relaxed);
+    running_ = threads_.size();
+    error_ = nullptr;
+    generation_++;
+  }
+  wake_.notify_all();
+  work(0);
+
+  unique_lock<mutex> lock(mutex_);
+  done_.wait(lock, [this] { return running_ == 0; });
+  task_ = nullptr;
+  if (error_) {
+    auto e = error_;
+    error_ = nullptr;
+    rethrow_exception(e);
+  }
+}
+
+/**
+ * Main loop of a background worker.
+ * @param worker index of the worker
+ */
+void ThreadPool::workerLoop(uint16_t worker) {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_) {
+        return;
+      }
+      seen = generation_;
+    }
+    work(worker);
+    {
+      lock_guard<mutex> lock(mutex_);
+      if (--running_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+/**
+ * Take tasks of the current batch until none is left.
+ * @param worker index of the worker
+ */
+void ThreadPool::work(uint16_t worker) {
+  uint32_t t;
+  while ((t = next_task_.fetch_add(1, memory_order_relaxed)) < n_tasks_) {
+    try {
+      (*task_)(t, worker);
+    } catch (...) {
+      lock_guard<mutex> lock(mutex_);
+      if (!error_) {
+        error_ = current_exception();
+      }
+    }
+  }
+}
+
+}  // namespace cube_util
@@ -2,10 +2,10 @@
 #include "cube_util/utils.hpp"
 
 #include <array>
-#include <random>
 
 #include <boost/algorithm/string/trim.hpp>
 
+#include "cube_util/random.hpp"
 #include "cube_util/scramble/scrambler_222.hpp"
 #include "cube_util/scramble/scrambler_333.hpp"
 #include "cube_util/scramble/scrambler_nnn.hpp"
@@ -14,9 +14,6 @@ namespace cube_util {
 
 namespace utils {
 
-using std::random_device;
-using std::default_random_engine;
-using std::uniform_int_distribution;
 using std::to_string;
 using std::array;
 
@@ -50,10 +47,10 @@ bool getNParity(uint64_t index, uint16_t n) {
 }
 
 function<int64_t()> randomizer(int64_t start, int64_t end) {
-  static random_device rd;
-  default_random_engine gen = default_random_engine(rd());
-  uniform_int_distribution<int64_t> dist(start, end);
-  return bind(dist, gen);
+  uint64_t bound = end - start + 1;
+  return [start, bound] {
+    return start + static_cast<int64_t>(threadRandomEngine().uniform(bound));
+  };
 }
 
 string scrambleString(int cubeSize, int length) {
@@ -0,0 +1,36 @@
+// Copyright 2019 Yunqi Ouyang
+#include "cube_util/warmup.hpp"
+
+#include "table_loaders.hpp"
+
+namespace cube_util {
+
+using tables::BuildPoolScope;
+using tables::get222TableLoaders;
+using tables::get333TableLoaders;
+using tables::getLoadedTables;
+using tables::load333SymmetryTable;
+
+vector<TableInfo> warmup(uint16_t nThreads, bool symmetryPruning) {
+  auto loaders = get333TableLoaders();
+  auto loaders222 = get222TableLoaders();
+  loaders.insert(loaders.end(), loaders222.begin(), loaders222.end());
+
+  // tables are handed out in order, so the tables a table depends on are
+  // usually being loaded already when it's needed, and each is generated on
+  // the thread loading it
+  ThreadPool pool(nThreads);
+  pool.run(loaders.size(), [&loaders](uint32_t task, uint16_t) {
+    BuildPoolScope scope(nullptr);
+    loaders[task]();
+  });
+  if (symmetryPruning) {
+    // it takes much longer than all the others, so it's generated on the
+    // whole pool once the tables it depends on are loaded
+    BuildPoolScope scope(&pool);
+    load333SymmetryTable();
+  }
+  return getLoadedTables();
+}
+
+}  // namespace cube_util
@@ -2,12 +2,28 @@
 #define BOOST_TEST_MODULE cube333
 #include <boost/test/unit_test.hpp>
 
+#include "cube_util/puzzle/coord_cube_333.hpp"
 #include "cube_util/puzzle/cubie_cube_333.hpp"
 #include "cube_util/cube_333_solver.hpp"
+#include "cube_util/pruning_bfs.hpp"
+#include "cube_util/random.hpp"
+#include "cube_util/thread_pool.hpp"
+
+using std::make_shared;
+using std::max;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 using cube_util::FaceletCubeNNN;
 using cube_util::CubieCube333;
+using cube_util::CoordCube333;
 using cube_util::Cube333Solver;
+using cube_util::MoveSequence;
+using cube_util::ThreadPool;
+using cube_util::Xoshiro256;
+using cube_util::kSearchStatsEnabled;
 
 using cube_util::enums::Moves::Ux1;
 using cube_util::enums::Moves::Ux2;
@@ -28,9 +44,24 @@ using cube_util::enums::Moves::Bx1;
 using cube_util::enums::Moves::Bx2;
 using cube_util::enums::Moves::Bx3;
 
+using cube_util::cube333::kNFlipSliceClass;
+using cube_util::cube333::kNMove;
+using cube_util::cube333::kNearSolvedDepth;
+using cube_util::cube333::EdgeGroups::kSliceEdges;
+using cube_util::cube333::kNCornerTwist;
+using cube_util::cube333::kNEdgeFlip;
+using cube_util::cube333::kSolvedTwist;
+using cube_util::cube333::kSolvedSlicePosition;
+using cube_util::cube333::kNSlicePosition;
+using cube_util::cube333::kNSymD4h;
 using cube_util::cube333::kPhase2MoveCount;
 using cube_util::cube333::kPhase2Move;
 
+using cube_util::utils::generateDistanceMod3;
+using cube_util::utils::generatePruning;
+using cube_util::utils::getMod3Pruning;
+using cube_util::utils::getPruning;
+
 BOOST_AUTO_TEST_SUITE(cube333)
 
 BOOST_AUTO_TEST_CASE(test_cube333) {
@@ -116,6 +147,47 @@ BOOST_AUTO_TEST_CASE(test_333_phase2_move_tables) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_coord_cube333) {
+  BOOST_CHECK(CoordCube333().isSolved());
+  BOOST_CHECK(CoordCube333(CubieCube333()) == CoordCube333());
+  BOOST_CHECK_EQUAL(CoordCube333().toCubieCube(), CubieCube333());
+
+  auto random = Xoshiro256(2);
+  for (auto i = 0; i < 20; i++) {
+    auto cc = CubieCube333::randomCube(&random);
+    auto coord = CoordCube333(cc);
+    BOOST_CHECK_EQUAL(coord.toCubieCube(), cc);
+    vector<uint16_t> moves;
+    for (auto j = 0; j < 30; j++) {
+      moves.push_back(random.uniform(kNMove));
+      cc.move(moves.back());
+    }
+    coord.applySequence(moves);
+    BOOST_CHECK(coord == CoordCube333(cc));
+    BOOST_CHECK_EQUAL(coord.toCubieCube(), cc);
+    BOOST_CHECK_EQUAL(coord.getSlicePosition(), cc.getSlicePositionIndex());
+
+    auto s = Cube333Solver(cc).solve();
+    coord.applySequence(*s);
+    BOOST_CHECK(coord.isSolved());
+  }
+
+  for (auto i = 0; i < 20; i++) {
+    auto cc = CubieCube333::randomDRCube(&random);
+    auto coord = CoordCube333(cc);
+    for (auto j = 0; j < 10; j++) {
+      auto move = kPhase2Move[random.uniform(kPhase2MoveCount)];
+      cc.move(move);
+      coord.move(move);
+    }
+    BOOST_CHECK(coord.isPhase1Solved());
+    BOOST_CHECK_EQUAL(coord.getCP(), cc.getCPIndex());
+    BOOST_CHECK_EQUAL(coord.getUD8EP(), cc.getUD8EPIndex());
+    BOOST_CHECK_EQUAL(coord.getSliceEP(), cc.getSliceEPIndex());
+    BOOST_CHECK_EQUAL(coord.getEdge4(kSliceEdges) % 24, cc.getSliceEPIndex());
+  }
+}
+
 BOOST_AUTO_TEST_CASE(test_333_solver) {
   CubieCube333 cc;
   // test moves: F' B U2 B R F U' F' U F' D2 // B' L2 U2 R2 F L2 B L2
@@ -146,4 +218,292 @@ BOOST_AUTO_TEST_CASE(test_333_solver) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_333_near_solved) {
+  BOOST_CHECK_EQUAL(Cube333Solver::getNearSolvedDistance(CubieCube333()), 0);
+  // canonical sequences of up to 4 moves are optimal
+  auto random = Xoshiro256(1);
+  for (auto length = 1; length <= kNearSolvedDepth; length++) {
+    for (auto i = 0; i < 100; i++) {
+      CubieCube333 cc;
+      auto lastAxis = 6;
+      for (auto j = 0; j < length; j++) {
+        uint16_t move;
+        do {
+          move = random.uniform(kNMove);
+        } while (move / 3 == lastAxis || move / 3 + 3 == lastAxis);
+        lastAxis = move / 3;
+        cc.move(move);
+      }
+      BOOST_CHECK_EQUAL(Cube333Solver::getNearSolvedDistance(cc), length);
+      auto solver = Cube333Solver(cc);
+      BOOST_CHECK(solver.isSolvableIn(length));
+      BOOST_CHECK(!solver.isSolvableIn(length - 1));
+    }
+  }
+  auto far = CubieCube333::randomCube(&random);
+  BOOST_CHECK_EQUAL(Cube333Solver::getNearSolvedDistance(far),
+                    kNearSolvedDepth + 1);
+  BOOST_CHECK(!Cube333Solver(far).isSolvableIn(kNearSolvedDepth));
+}
+
+BOOST_AUTO_TEST_CASE(test_333_parallel_solver) {
+  auto pool = make_shared<ThreadPool>(4);
+  const auto N = 20;
+  const CubieCube333 idc;
+  for (auto i = 0; i < N; i++) {
+    auto cc = CubieCube333::randomCube();
+    auto serial = Cube333Solver(cc).solve(21)->getMoves();
+
+    auto solver = Cube333Solver(cc);
+    solver.setThreadPool(pool, true);
+    BOOST_CHECK(solver.solve(21)->getMoves() == serial);
+
+    solver = Cube333Solver(cc);
+    solver.setThreadPool(pool);
+    auto s = solver.solve(21);
+    BOOST_CHECK_LE(s->getLength(), 21);
+    auto cc2 = CubieCube333(cc);
+    for (auto m : s->getMoves()) {
+      cc2.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc2, idc);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_333_batch_solver) {
+  const auto N = 50;
+  const CubieCube333 idc;
+  auto cubes = vector<CubieCube333>();
+  for (auto i = 0; i < N; i++) {
+    cubes.push_back(CubieCube333::randomCube());
+  }
+  auto solutions = vector<unique_ptr<MoveSequence>>(N);
+  Cube333Solver::solveBatch(cubes, 21, solutions.data(),
+                            make_shared<ThreadPool>(3));
+  for (auto i = 0; i < N; i++) {
+    BOOST_CHECK(solutions[i]->getMoves() ==
+                Cube333Solver(cubes[i]).solve(21)->getMoves());
+    auto cc = CubieCube333(cubes[i]);
+    for (auto m : solutions[i]->getMoves()) {
+      cc.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc, idc);
+  }
+
+  // random cubes are practically never solvable in 5 moves
+  cubes.push_back(idc);
+  solutions.resize(cubes.size());
+  Cube333Solver::solveBatch(cubes, 5, solutions.data());
+  for (auto i = 0; i < N; i++) {
+    BOOST_CHECK(solutions[i] == nullptr);
+  }
+  BOOST_CHECK_EQUAL(solutions[N]->getLength(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_333_search_stats) {
+  auto cc = CubieCube333::randomCube();
+  auto solver = Cube333Solver(cc);
+  solver.solve(21);
+  const auto &stats = solver.getSearchStats();
+  if (!kSearchStatsEnabled) {
+    BOOST_CHECK_EQUAL(stats.nodes(), 0);
+    BOOST_CHECK_EQUAL(stats.phase1Lengths, 0);
+    return;
+  }
+  // the root is expanded once for each phase 1 length
+  BOOST_CHECK_EQUAL(stats.phase1Nodes[0], stats.phase1Lengths);
+  BOOST_CHECK_GT(stats.phase2Entries, stats.phase2Rejections);
+  BOOST_CHECK_GE(stats.phase2Nodes[0],
+                 stats.phase2Entries - stats.phase2Rejections);
+  BOOST_CHECK_GT(stats.pruningLookups, stats.nodes());
+  BOOST_CHECK_GT(stats.phase2Seconds, 0);
+  BOOST_CHECK_GE(stats.phase1Seconds(), 0);
+
+  auto sixWay = Cube333Solver(cc);
+  sixWay.setSixWaySearch(true);
+  sixWay.solve(21);
+  const auto &sixWayStats = sixWay.getSearchStats();
+  BOOST_CHECK_EQUAL(sixWayStats.phase1Nodes[0], sixWayStats.phase1Lengths);
+  BOOST_CHECK_GT(sixWayStats.phase2Entries, 0);
+
+  // times add up over the threads of a pool
+  auto pooled = Cube333Solver(cc);
+  pooled.setThreadPool(make_shared<ThreadPool>(4));
+  pooled.solve(21);
+  const auto &pooledStats = pooled.getSearchStats();
+  BOOST_CHECK_GT(pooledStats.phase2Seconds, 0);
+  BOOST_CHECK_GE(pooledStats.phase1Seconds(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_333_phase1_children) {
+  // the SIMD kernel the search uses agrees with the scalar one
+  auto random = Xoshiro256(3);
+  for (auto i = 0; i < 10000; i++) {
+    uint16_t co = random.uniform(kNCornerTwist);
+    uint16_t eo = random.uniform(kNEdgeFlip);
+    uint16_t slice = random.uniform(kNSlicePosition);
+    uint16_t moveCount = random.uniform(13);
+    uint32_t below, above, scalarBelow, scalarAbove;
+    Cube333Solver::comparePhase1Children(co, eo, slice, moveCount, &below,
+                                         &above);
+    Cube333Solver::comparePhase1Children(co, eo, slice, moveCount,
+                                         &scalarBelow, &scalarAbove, false);
+    BOOST_REQUIRE_EQUAL(below, scalarBelow);
+    BOOST_REQUIRE_EQUAL(above, scalarAbove);
+    for (auto move = 0; move < kNMove; move++) {
+      auto newSlice = CubieCube333::getSlicePositionMove(slice, move);
+      auto p = max(Cube333Solver::getTwistSlicePruning(
+                       CubieCube333::getTwistMove(co, move), newSlice),
+                   Cube333Solver::getFlipSlicePruning(
+                       CubieCube333::getFlipMove(eo, move), newSlice));
+      BOOST_REQUIRE_EQUAL(scalarBelow >> move & 1, p < moveCount);
+      BOOST_REQUIRE_EQUAL(scalarAbove >> move & 1, p > moveCount);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_333_symmetry_pruning) {
+  for (auto c = 0; c < kNFlipSliceClass; c += 97) {
+    auto rep = CubieCube333::getFlipSliceRep(c);
+    BOOST_CHECK_EQUAL(CubieCube333::getFlipSliceSym(rep / kNSlicePosition,
+                                                    rep % kNSlicePosition),
+                      c * kNSymD4h);
+    BOOST_CHECK(CubieCube333::getFlipSliceSelfSym(c) & 1);
+  }
+
+  const auto N = 20;
+  const CubieCube333 idc;
+  for (auto i = 0; i < N; i++) {
+    auto cc = CubieCube333::randomCube();
+    auto flip = cc.getEOIndex();
+    auto slice = cc.getSlicePositionIndex();
+    auto twist = cc.getCOIndex();
+    auto p = Cube333Solver::getFlipSliceTwistPruning(flip, slice, twist);
+    BOOST_CHECK_EQUAL(
+        Cube333Solver::getFlipSliceTwistDistanceMod3(flip, slice, twist),
+        p % 3);
+    BOOST_CHECK_GE(p, max(Cube333Solver::getFlipSlicePruning(flip, slice),
+                          Cube333Solver::getTwistSlicePruning(twist, slice)));
+    for (auto m = 0; m < 18; m++) {
+      auto cc2 = CubieCube333(cc);
+      cc2.move(m);
+      auto p2 = Cube333Solver::getFlipSliceTwistPruning(
+          cc2.getEOIndex(), cc2.getSlicePositionIndex(), cc2.getCOIndex());
+      BOOST_CHECK_LE(abs(p2 - p), 1);
+    }
+
+    auto solver = Cube333Solver(cc);
+    solver.setSymmetryPruning(true);
+    auto s = solver.solve(21);
+    BOOST_CHECK_LE(s->getLength(), 21);
+    for (auto m : s->getMoves()) {
+      cc.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc, idc);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_333_improving_solver) {
+  const auto N = 5;
+  const CubieCube333 idc;
+  for (auto i = 0; i < N; i++) {
+    auto cc = CubieCube333::randomCube();
+    auto first = Cube333Solver(cc).solve()->getMoves();
+    auto solver = Cube333Solver(cc);
+    BOOST_CHECK(solver.solveImproving(30, steady_clock::now() +
+                                      milliseconds(1000))->getMoves() == first);
+
+    vector<vector<uint16_t>> found;
+    solver = Cube333Solver(cc);
+    auto s = solver.solveImproving(
+        0, steady_clock::now() + milliseconds(200),
+        [&found](const MoveSequence &improved) {
+          found.push_back(improved.getMoves());
+        });
+    BOOST_REQUIRE(!found.empty());
+    BOOST_CHECK(found.front() == first);
+    for (auto j = 1; j < found.size(); j++) {
+      BOOST_CHECK_LT(found[j].size(), found[j - 1].size());
+    }
+    BOOST_CHECK(s->getMoves() == found.back());
+    auto cc2 = CubieCube333(cc);
+    for (auto m : s->getMoves()) {
+      cc2.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc2, idc);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_333_six_way_solver) {
+  const auto N = 20;
+  const CubieCube333 idc;
+  for (auto i = 0; i < N; i++) {
+    auto cc = CubieCube333::randomCube();
+    // a solution applied to the solved cube gives the inverse
+    auto inv = CubieCube333();
+    for (auto m : Cube333Solver(cc).solve()->getMoves()) {
+      inv.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc.inverse(), inv);
+    for (auto t = 0; t < 3; t++) {
+      auto rotated = cc.rotateURF(t);
+      auto cc2 = CubieCube333(cc);
+      for (auto m : Cube333Solver(rotated).solve()->getMoves()) {
+        cc2.move(CubieCube333::getURFMoveConj(m, t));
+      }
+      BOOST_CHECK_EQUAL(cc2, idc);
+    }
+
+    auto solver = Cube333Solver(cc);
+    solver.setSixWaySearch(true);
+    auto s = solver.solve(21);
+    BOOST_CHECK_LE(s->getLength(), 21);
+    for (auto m : s->getMoves()) {
+      cc.move(m);
+    }
+    BOOST_CHECK_EQUAL(cc, idc);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_333_pruning_bfs) {
+  const uint32_t N = kNCornerTwist * kNSlicePosition;
+  auto doMove = [](uint32_t index, uint16_t move) {
+    return CubieCube333::getTwistMove(index / kNSlicePosition, move) *
+           kNSlicePosition +
+           CubieCube333::getSlicePositionMove(index % kNSlicePosition, move);
+  };
+  // generated on a pool, while the solver generates it on a single thread
+  auto table = vector<uint16_t>((N + 3) >> 2);
+  ThreadPool pool(4);
+  generatePruning(table.data(), N,
+                  kSolvedTwist * kNSlicePosition + kSolvedSlicePosition,
+                  kNMove, doMove, &pool);
+  for (uint32_t index = 0; index < N; index++) {
+    auto p = getPruning(table, index);
+    BOOST_REQUIRE_EQUAL(p, Cube333Solver::getTwistSlicePruning(
+        index / kNSlicePosition, index % kNSlicePosition));
+    // every state is one move away from a state one move closer to solved
+    auto closer = p == 0;
+    for (auto move = 0; move < kNMove; move++) {
+      auto q = getPruning(table, doMove(index, move));
+      BOOST_REQUIRE_LE(p, q + 1);
+      closer |= q + 1 == p;
+    }
+    BOOST_REQUIRE(closer);
+  }
+
+  // distances modulo 3 are searched on the 2 bit table directly
+  auto mod3 = vector<uint16_t>((N + 7) >> 3);
+  auto pooledMod3 = vector<uint16_t>((N + 7) >> 3);
+  auto solved = kSolvedTwist * kNSlicePosition + kSolvedSlicePosition;
+  generateDistanceMod3(mod3.data(), N, solved, kNMove, doMove);
+  generateDistanceMod3(pooledMod3.data(), N, solved, kNMove, doMove, &pool);
+  for (uint32_t index = 0; index < N; index++) {
+    BOOST_REQUIRE_EQUAL(getMod3Pruning(mod3, index),
+                        getPruning(table, index) % 3);
+    BOOST_REQUIRE_EQUAL(getMod3Pruning(pooledMod3, index),
+                        getPruning(table, index) % 3);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,19 +4,52 @@
 
 #include <boost/regex.hpp>
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
 #include "cube_util/puzzle/cubie_cube_222.hpp"
 #include "cube_util/puzzle/facelet_cube_nnn.hpp"
 #include "cube_util/cube_222_solver.hpp"
+#include "cube_util/bounded_queue.hpp"
+#include "cube_util/move_automaton.hpp"
+#include "cube_util/random.hpp"
+#include "cube_util/scramble/pooled_scrambler.hpp"
+#include "cube_util/scramble/scrambler.hpp"
+#include "cube_util/table_store.hpp"
+#include "cube_util/warmup.hpp"
 #include "cube_util/utils.hpp"
 
+using std::make_shared;
+using std::unique_ptr;
 using std::vector;
 using std::array;
+using std::fstream;
+using std::string;
 
 using boost::regex;
 
 using cube_util::FaceletCubeNNN;
 using cube_util::CubieCube222;
 using cube_util::Cube222Solver;
+using cube_util::MoveSequence;
+using cube_util::Scrambler;
+using cube_util::PooledScrambler;
+using cube_util::BoundedQueue;
+using cube_util::MoveAutomaton;
+using cube_util::findRedundantSequences;
+using cube_util::Xoshiro256;
+using cube_util::seedThreadRandomEngine;
+using cube_util::ThreadPool;
+using cube_util::kSearchStatsEnabled;
 
 using cube_util::enums::Colors::U;
 using cube_util::enums::Colors::R;
@@ -33,6 +66,8 @@ using cube_util::enums::Moves::Rx2;
 using cube_util::enums::Moves::Rx3;
 using cube_util::enums::Moves::Fx1;
 
+using cube_util::cube222::kNTwist;
+
 using cube_util::utils::getNPerm;
 using cube_util::utils::setNPerm;
 using cube_util::utils::getNTwist;
@@ -41,6 +76,18 @@ using cube_util::utils::cycle4;
 using cube_util::utils::scrambleString;
 using cube_util::utils::reverseMove;
 
+using cube_util::warmup;
+
+using cube_util::tables::getHugePages;
+using cube_util::tables::getLoadedTables;
+using cube_util::tables::getTableDirectory;
+using cube_util::tables::getVerifyTables;
+using cube_util::tables::kHugePageSize;
+using cube_util::tables::loadTable;
+using cube_util::tables::setHugePages;
+using cube_util::tables::setTableDirectory;
+using cube_util::tables::setVerifyTables;
+
 BOOST_AUTO_TEST_SUITE(cube_model)
 
 BOOST_AUTO_TEST_CASE(test_faceletcube) {
@@ -60,6 +107,186 @@ BOOST_AUTO_TEST_CASE(test_faceletcube) {
   BOOST_CHECK(fc.getFacelets() == exp);
 }
 
+BOOST_AUTO_TEST_CASE(test_faceletcube_wide_moves) {
+  // wide moves turn the same facelets as their layers turned one by one
+  for (uint16_t size : {7, 8, 17}) {
+    for (auto shift = 1; shift <= size; shift++) {
+      for (auto amount = 1; amount <= 4; amount++) {
+        auto wide = FaceletCubeNNN(size);
+        auto layers = FaceletCubeNNN(size);
+        wide.moveRw(3, 1);
+        wide.moveF(1);
+        layers.moveRw(3, 1);
+        layers.moveF(1);
+        if (shift == 1) {
+          wide.moveU(amount);
+          wide.moveD(amount);
+          wide.moveR(amount);
+          wide.moveL(amount);
+          wide.moveF(amount);
+          wide.moveB(amount);
+        } else {
+          wide.moveUw(shift, amount);
+          wide.moveDw(shift, amount);
+          wide.moveRw(shift, amount);
+          wide.moveLw(shift, amount);
+          wide.moveFw(shift, amount);
+          wide.moveBw(shift, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.moveu(l, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.moved(l, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.mover(l, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.movel(l, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.movef(l, amount);
+        }
+        for (auto l = 1; l <= shift; l++) {
+          layers.moveb(l, amount);
+        }
+        BOOST_CHECK(wide == layers);
+      }
+    }
+  }
+
+  // a cube rebuilt from its facelets compares and turns like the cube
+  auto fc = FaceletCubeNNN(5);
+  fc.moveU();
+  fc.moveD(2);
+  auto copy = FaceletCubeNNN(5, fc.getFacelets());
+  BOOST_CHECK(fc == copy);
+  BOOST_CHECK_EQUAL(fc.prettify(), copy.prettify());
+  fc.moveR();
+  copy.moveR();
+  BOOST_CHECK(fc.getFacelets() == copy.getFacelets());
+  fc.moveU(3);
+  fc.moveU();
+  BOOST_CHECK(fc == copy);
+  BOOST_CHECK(!(fc == FaceletCubeNNN(5)));
+}
+
+BOOST_AUTO_TEST_CASE(test_faceletcube_solvable_in) {
+  // compare with trying every move
+  for (uint16_t size : {3, 4, 5, 6}) {
+    const uint16_t nMove = (size - 1) * 9;
+    auto solved = FaceletCubeNNN(size);
+    auto solvableIn1 = [&](const FaceletCubeNNN &fc) {
+      for (auto m = 0; m < nMove; m++) {
+        auto another = fc;
+        another.move(m);
+        if (another == solved) {
+          return true;
+        }
+      }
+      return fc == solved;
+    };
+    for (auto m1 = 0; m1 < nMove; m1++) {
+      auto fc = FaceletCubeNNN(size);
+      fc.move(m1);
+      BOOST_CHECK(fc.isSolvableIn(1));
+      for (auto m2 = 0; m2 < nMove; m2++) {
+        auto another = fc;
+        another.move(m2);
+        BOOST_CHECK(another.isSolvableIn(2));
+        BOOST_CHECK_EQUAL(another.isSolvableIn(1), solvableIn1(another));
+      }
+    }
+    // three moves on different axes are not solvable in 2 moves
+    auto fc = FaceletCubeNNN(size);
+    fc.moveR();
+    fc.moveU();
+    fc.moveF();
+    BOOST_CHECK(!fc.isSolvableIn(2));
+    fc.moveB();
+    BOOST_CHECK(!fc.isSolvableIn(2));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_faceletcube_hash) {
+  // the hash kept by moves equals the one computed from the facelets, and
+  // the one of a cube hashed only after the moves
+  Xoshiro256 engine(2019);
+  for (uint16_t size : {2, 3, 4, 5, 8, 9}) {
+    const uint16_t nMove = size * 18;
+    auto fc = FaceletCubeNNN(size);
+    auto unhashed = FaceletCubeNNN(size);
+    for (auto i = 0; i < 200; i++) {
+      auto move = engine.uniform(nMove);
+      fc.move(move);
+      unhashed.move(move);
+      if (i % 10 == 0) {
+        auto layer = engine.uniform(size) + 1;
+        auto amount = engine.uniform(3) + 1;
+        switch (i / 10 % 3) {
+          case 0:
+            fc.moveu(layer, amount);
+            unhashed.moveu(layer, amount);
+            break;
+          case 1:
+            fc.mover(layer, amount);
+            unhashed.mover(layer, amount);
+            break;
+          case 2:
+            fc.movef(layer, amount);
+            unhashed.movef(layer, amount);
+            break;
+        }
+      }
+      auto copy = FaceletCubeNNN(size, fc.getFacelets());
+      BOOST_CHECK_EQUAL(fc.hash(), copy.hash());
+      BOOST_CHECK(fc == copy);
+    }
+    BOOST_CHECK(fc == unhashed);
+    BOOST_CHECK_EQUAL(fc.hash(), unhashed.hash());
+  }
+
+  std::unordered_set<FaceletCubeNNN> states;
+  auto fc = FaceletCubeNNN(4);
+  states.insert(fc);
+  fc.moveU();
+  BOOST_CHECK(states.count(fc) == 0);
+  states.insert(fc);
+  fc.moveUw(4, 1);
+  fc.moveDw(4, 1);
+  BOOST_CHECK(states.count(fc) == 1);
+  fc.moveU(3);
+  BOOST_CHECK(states.count(FaceletCubeNNN(4)) == 1);
+  BOOST_CHECK(states.count(fc) == 1);
+  BOOST_CHECK(fc == FaceletCubeNNN(4));
+  BOOST_CHECK_EQUAL(states.size(), 2);
+
+  // threads hashing the same const cube for the first time agree
+  auto scrambled = FaceletCubeNNN(9);
+  for (auto i = 0; i < 50; i++) {
+    scrambled.move(engine.uniform(9 * 18));
+  }
+  const auto shared = scrambled;
+  auto expected = FaceletCubeNNN(9, shared.getFacelets()).hash();
+  vector<uint64_t> hashes(4);
+  vector<std::thread> threads;
+  for (size_t t = 0; t < hashes.size(); t++) {
+    threads.emplace_back([&shared, &hashes, t] {
+      hashes[t] = std::hash<FaceletCubeNNN>()(shared);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto h : hashes) {
+    BOOST_CHECK_EQUAL(h, expected);
+  }
+
+  BOOST_CHECK_THROW(FaceletCubeNNN(2, vector<uint16_t>(24, 6)),
+                    std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(test_cube222) {
   FaceletCubeNNN ifc = FaceletCubeNNN(2);
   FaceletCubeNNN fc = FaceletCubeNNN(2);
@@ -109,6 +336,62 @@ BOOST_AUTO_TEST_CASE(test_cube222) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_222_search_stats) {
+  auto solver = Cube222Solver(CubieCube222::randomCube());
+  auto length = solver.solve()->getLength();
+  const auto &stats = solver.getSearchStats();
+  if (!kSearchStatsEnabled) {
+    BOOST_CHECK_EQUAL(stats.nodes(), 0);
+    return;
+  }
+  BOOST_CHECK_EQUAL(stats.phase1Lengths, length + 1);
+  BOOST_CHECK_EQUAL(stats.phase1Nodes[0], length + 1);
+  // only the solved state passes pruning at the last depth
+  BOOST_CHECK_EQUAL(stats.phase1Nodes[length], 1);
+  BOOST_CHECK_EQUAL(stats.phase2Entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_222_distance_table) {
+  BOOST_CHECK_EQUAL(Cube222Solver::getDistance(0), 0);
+  BOOST_CHECK_EQUAL(
+      Cube222Solver::getDistance(CubieCube222::getPermMove(0, Rx1) * kNTwist +
+                                 CubieCube222::getTwistMove(0, Rx1)), 1);
+
+  const auto N = 100;
+  for (auto i = 0; i < N; i++) {
+    auto cc = CubieCube222::randomCube();
+    auto solver = Cube222Solver(cc);
+    auto tableSolver = Cube222Solver(cc);
+    tableSolver.setDistanceTable(true);
+    auto s = solver.solve();
+    BOOST_CHECK(tableSolver.solve()->getMoves() == s->getMoves());
+    BOOST_CHECK_EQUAL(
+        Cube222Solver::getDistance(cc.getCPIndex() * kNTwist +
+                                   cc.getCOIndex()), s->getLength());
+    BOOST_CHECK(tableSolver.generate(11)->getMoves() ==
+                solver.generate(11)->getMoves());
+    BOOST_CHECK(tableSolver.isSolvableIn(s->getLength()));
+    if (s->getLength() > 0) {
+      BOOST_CHECK(!tableSolver.isSolvableIn(s->getLength() - 1));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_222_batch_solver) {
+  const auto N = 200;
+  auto cubes = vector<CubieCube222>();
+  for (auto i = 0; i < N; i++) {
+    cubes.push_back(CubieCube222::randomCube());
+  }
+  auto solutions = vector<unique_ptr<MoveSequence>>(N);
+  Cube222Solver::solveBatch(cubes, 0, solutions.data(),
+                            make_shared<ThreadPool>(3));
+  for (auto i = 0; i < N; i++) {
+    BOOST_CHECK(solutions[i]->getMoves() ==
+                Cube222Solver(cubes[i]).solve()->getMoves());
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(utils)
@@ -156,6 +439,59 @@ BOOST_AUTO_TEST_CASE(test_getSetNTwist) {
   BOOST_CHECK(arr1 == exp1);
 }
 
+BOOST_AUTO_TEST_CASE(test_move_automaton) {
+  // U, R and F moves of 2x2x2
+  const uint16_t nMoves = 9;
+  auto doMove = [](CubieCube222 c, uint16_t move) {
+    c.move(move);
+    return c;
+  };
+  auto key = [](const CubieCube222 &c) {
+    return c.getCPIndex() * kNTwist + c.getCOIndex();
+  };
+  auto automaton = MoveAutomaton(nMoves, findRedundantSequences(
+      nMoves, 4, CubieCube222(), doMove, key));
+  auto state = automaton.next(MoveAutomaton::kStart, Ux1);
+  BOOST_CHECK_EQUAL(automaton.next(state, Ux1), MoveAutomaton::kDead);
+  BOOST_CHECK_EQUAL(automaton.getMoves(state) >> Ux1 & 7, 0);
+  BOOST_CHECK_NE(automaton.next(state, Rx1), MoveAutomaton::kDead);
+
+  // sequences accepted up to the length of the redundant ones reach
+  // distinct states, which are all the 1 + 9 + 54 + 321 + 1847 states
+  // within 4 moves
+  std::set<uint32_t> seen;
+  auto accepted = 0;
+  std::function<void(CubieCube222, uint16_t, uint16_t)> walk =
+      [&](CubieCube222 c, uint16_t s, uint16_t length) {
+    accepted++;
+    seen.insert(key(c));
+    if (length == 4) {
+      return;
+    }
+    for (uint16_t move = 0; move < nMoves; move++) {
+      if (automaton.next(s, move) != MoveAutomaton::kDead) {
+        walk(doMove(c, move), automaton.next(s, move), length + 1);
+      }
+    }
+  };
+  walk(CubieCube222(), MoveAutomaton::kStart, 0);
+  BOOST_CHECK_EQUAL(accepted, seen.size());
+  BOOST_CHECK_EQUAL(seen.size(), 2232);
+
+  // all the 2^16 sequences of 16 moves out of 2 need 2^17 - 1 states
+  vector<vector<uint16_t>> forbidden;
+  for (uint32_t bits = 0; bits < 1u << 16; bits++) {
+    vector<uint16_t> s;
+    for (auto i = 0; i < 16; i++) {
+      s.push_back(bits >> i & 1);
+    }
+    forbidden.push_back(s);
+  }
+  BOOST_CHECK_THROW(MoveAutomaton(2, forbidden), std::invalid_argument);
+  forbidden.resize(1u << 13);
+  BOOST_CHECK_NO_THROW(MoveAutomaton(2, forbidden));
+}
+
 BOOST_AUTO_TEST_CASE(test_scramble) {
   auto re2 = regex("^[URF][2']?( [URF][2']?){10}$");
   auto re3 = regex("^[URFDLB][2']?( [URFDLB][2']?){1,20}$");
@@ -180,4 +516,227 @@ BOOST_AUTO_TEST_CASE(test_scramble) {
   BOOST_CHECK(regex_match(scr, re7));
 }
 
+BOOST_AUTO_TEST_CASE(test_seeded_scramble) {
+  for (auto size : {2, 3, 5}) {
+    auto s1 = Scrambler::instance(size);
+    auto s2 = Scrambler::instance(size);
+    s1->seed(42);
+    s2->seed(42);
+    for (auto i = 0; i < 3; i++) {
+      BOOST_CHECK_EQUAL(s1->scramble()->toString(),
+                        s2->scramble()->toString());
+    }
+    s2->seed(43);
+    BOOST_CHECK_NE(s1->scramble()->toString(), s2->scramble()->toString());
+  }
+
+  for (auto size : {2, 3, 5}) {
+    auto serial = Scrambler::instance(size);
+    serial->seed(1);
+    auto first = serial->scrambleAt(42, 1, 0)->toString();
+    auto second = serial->scrambleAt(42, 1, 1)->toString();
+    BOOST_CHECK_NE(first, second);
+    BOOST_CHECK_NE(serial->scrambleAt(42, 2, 0)->toString(), first);
+    BOOST_CHECK_NE(serial->scrambleAt(43, 1, 0)->toString(), first);
+
+    // a shard starting in the middle of the set
+    auto shard = Scrambler::instance(size);
+    BOOST_CHECK_EQUAL(shard->scrambleAt(42, 1, 1)->toString(), second);
+    BOOST_CHECK_EQUAL(shard->scrambleAt(42, 1, 0)->toString(), first);
+
+    // the engine of the scrambler is left untouched
+    auto seeded = Scrambler::instance(size);
+    seeded->seed(1);
+    BOOST_CHECK_EQUAL(seeded->scramble()->toString(),
+                      serial->scramble()->toString());
+  }
+
+  seedThreadRandomEngine(7);
+  auto cc = CubieCube222::randomCube();
+  seedThreadRandomEngine(7);
+  BOOST_CHECK(CubieCube222::randomCube() == cc);
+  auto engine = Xoshiro256(7);
+  BOOST_CHECK(CubieCube222::randomCube(&engine) == cc);
+
+  auto counts = array<int, 6>();
+  for (auto i = 0; i < 6000; i++) {
+    counts[engine.uniform(6)]++;
+  }
+  for (auto c : counts) {
+    BOOST_CHECK(c > 800 && c < 1200);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_pooled_scramble) {
+  BoundedQueue<int> queue(3);
+  for (auto i = 0; i < 3; i++) {
+    BOOST_CHECK(queue.push(&i));
+  }
+  auto value = 3;
+  BOOST_CHECK(!queue.push(&value));
+  BOOST_CHECK_EQUAL(queue.size(), 3);
+  for (auto i = 0; i < 3; i++) {
+    BOOST_CHECK(queue.pop(&value));
+    BOOST_CHECK_EQUAL(value, i);
+  }
+  BOOST_CHECK(!queue.pop(&value));
+
+  auto re2 = regex("^[URF][2']?( [URF][2']?){10}$");
+  PooledScrambler pool(2, 8, 2);
+  for (auto i = 0; i < 1000 && pool.getMetrics().size < 8; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  auto metrics = pool.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.size, 8);
+  BOOST_CHECK_EQUAL(metrics.capacity, 8);
+  BOOST_CHECK_EQUAL(metrics.lowWaterMark, 8);
+  BOOST_CHECK(metrics.refillRate > 0);
+  for (auto i = 0; i < 50; i++) {
+    BOOST_CHECK(regex_match(pool.scramble()->toString(), re2));
+  }
+  metrics = pool.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.served, 50);
+  BOOST_CHECK(metrics.lowWaterMark < 8);
+  BOOST_CHECK(metrics.produced + metrics.fallbacks >= 50);
+
+  pool.resetMetrics();
+  metrics = pool.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.served, 0);
+  BOOST_CHECK_EQUAL(metrics.fallbacks, 0);
+  BOOST_CHECK_EQUAL(metrics.lowWaterMark, metrics.size);
+  BOOST_CHECK_EQUAL(metrics.failedProducers, 0);
+
+  // the first producer fails, the other one keeps the queue filled
+  std::atomic<int> created(0);
+  PooledScrambler halfPool([&created] {
+    if (created++ == 0) {
+      throw std::runtime_error("first scrambler");
+    }
+    return Scrambler::instance(2);
+  }, 8, 2);
+  for (auto i = 0; i < 1000 && halfPool.getMetrics().size < 8; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  metrics = halfPool.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.failedProducers, 1);
+  BOOST_CHECK_EQUAL(metrics.size, 8);
+  BOOST_CHECK(metrics.refillRate > 0);
+  BOOST_CHECK(regex_match(halfPool.scramble()->toString(), re2));
+
+  // with no producer left an empty queue rethrows
+  PooledScrambler failedPool([]() -> unique_ptr<Scrambler> {
+    throw std::runtime_error("no scrambler");
+  }, 8, 2);
+  for (auto i = 0; i < 1000 && failedPool.getMetrics().failedProducers < 2;
+       i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  metrics = failedPool.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.failedProducers, 2);
+  BOOST_CHECK_EQUAL(metrics.refillRate, 0);
+  BOOST_CHECK_THROW(failedPool.scramble(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_table_store) {
+  char dirTemplate[] = "/tmp/cube_util_tables_XXXXXX";
+  BOOST_REQUIRE(mkdtemp(dirTemplate) != nullptr);
+  auto directory = string(dirTemplate);
+  auto oldDirectory = getTableDirectory();
+  setTableDirectory(directory);
+
+  auto generated = 0;
+  uint32_t size = 1000;
+  auto generate = [&generated, &size](uint32_t *table) {
+    generated++;
+    for (uint32_t i = 0; i < size; i++) {
+      table[i] = i * i;
+    }
+  };
+  auto check = [&size](const uint32_t *table) {
+    for (uint32_t i = 0; i < size; i++) {
+      if (table[i] != i * i) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 1);
+  // loaded from the file
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 1);
+  // dimensions don't match
+  size = 999;
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 2);
+
+  // content doesn't match the checksum, only found when verifying
+  auto path = directory + "/test_table.tbl";
+  {
+    fstream file(path, fstream::in | fstream::out | fstream::binary);
+    file.seekp(-1, fstream::end);
+    file.put(0x55);
+  }
+  BOOST_CHECK(!check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 2);
+  auto oldVerify = getVerifyTables();
+  setVerifyTables(true);
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 3);
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 3);
+  setVerifyTables(oldVerify);
+
+  // big tables backed by huge pages, both generated and loaded from the file
+  auto oldHugePages = getHugePages();
+  setHugePages(true);
+  size = kHugePageSize / sizeof(uint32_t);
+  BOOST_CHECK(check(loadTable<uint32_t>("test_huge_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 4);
+  BOOST_CHECK(getLoadedTables().back().hugePages);
+  BOOST_CHECK(check(loadTable<uint32_t>("test_huge_table", size, generate)));
+  BOOST_CHECK_EQUAL(generated, 4);
+  BOOST_CHECK(getLoadedTables().back().mapped);
+  BOOST_CHECK(getLoadedTables().back().hugePages);
+  // small tables are not
+  size = 1000;
+  BOOST_CHECK(check(loadTable<uint32_t>("test_table", size, generate)));
+  BOOST_CHECK(!getLoadedTables().back().hugePages);
+  setHugePages(oldHugePages);
+
+  setTableDirectory(oldDirectory);
+  remove(path.c_str());
+  remove((directory + "/test_huge_table.tbl").c_str());
+  remove(directory.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_warmup) {
+  auto report = warmup(4);
+  auto find = [&report](const string &name) {
+    for (const auto &info : report) {
+      if (info.name == name) {
+        return true;
+      }
+    }
+    return false;
+  };
+  BOOST_CHECK(find("222_perm_prun"));
+  BOOST_CHECK(find("222_twist_prun"));
+  BOOST_CHECK(find("333_flip_slice_prun"));
+  BOOST_CHECK(find("333_ud8_ep_slice_ep_prun"));
+  BOOST_CHECK(!find("333_flip_slice_twist_dist"));
+  // built in memory only
+  BOOST_CHECK(find("222_automaton"));
+  BOOST_CHECK(find("333_near_solved"));
+  BOOST_CHECK(find("333_phase1_automaton"));
+  BOOST_CHECK(find("333_phase2_automaton"));
+  for (const auto &info : report) {
+    BOOST_CHECK_GT(info.bytes, 0);
+    BOOST_CHECK_GE(info.seconds, 0);
+  }
+  // nothing loaded again
+  BOOST_CHECK_EQUAL(warmup(4).size(), report.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()